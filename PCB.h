@@ -1,31 +1,173 @@
 #ifndef PCB_H
 #define PCB_H
 
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
-class PCB {
+#include "groups.h"
+
+#define NOT_STARTED ((uint64_t) -1) // proc_table_t::start before the first dispatch
+#define NOT_ENDED 0 // proc_table_t::end of a process which never terminated
+#define CLOCK_LAST ((size_t) -1) // proc_table_t::Clock of a maxed process: after every real clock
+
+/* proc_table_t::state of a process. Written by the scheduler on every
+ * transition, so the interactive view never has to search the queues.
+ */
+enum proc_state_t
+{
+	ST_NEW,
+	ST_READY,
+	ST_RUNNING,
+	ST_IO,
+	ST_ENDED,
+	ST_ABORTED
+};
+
+/* index of a process in the proc_table_t. The queues only hold these. */
+typedef uint32_t pidx_t;
+#define NO_PROC ((pidx_t) -1) // no process, ends the lists threaded through pidx_t
+
+/* Every process is stored exactly once, here, as a structure of arrays:
+ * process pidx_t i is described by pid[i], bst[i], ... Comparators and
+ * the dispatcher only pull in the columns they read, and the loading and
+ * statistics passes run over whole columns at a time (see simd.h).
+ */
+class proc_table_t
+{
 public:
-	int pid; // PID
-	int bst; // Burst Time
-	int arr; // Arrival Time
-	int pri; // Priority
-	int dline; // Deadline
-	int io; // IO time
-
-	int io_counter; // IO counter: auxiliary for doing IO
-	size_t Clock; // time when the process was pushed in the ready queue: ageing
-
-	void print()
-	{
-		std::cerr << "pid: " << pid << std::endl;
-		std::cerr << "bst: " << bst << std::endl;
-		std::cerr << "arr: " << arr << std::endl;
-		std::cerr << "pri: " << pri << std::endl;
-		std::cerr << "dline: " << dline << std::endl;
-		std::cerr << "io: " << io << std::endl;
-		std::cerr << "Clock: " << Clock << std::endl;
+	/* columns read from the file */
+	std::vector<int32_t> pid; // PID
+	std::vector<int32_t> bst; // Burst Time (remaining)
+	std::vector<int32_t> arr; // Arrival Time
+	std::vector<uint8_t> pri; // Priority: [0,49] user, [50,99] kernel
+	std::vector<int32_t> dline; // Deadline
+	std::vector<int32_t> io; // IO time
+	std::vector<int32_t> dev; // IO device, 0 if the file has none
+	std::vector<int32_t> pos; // position on the IO device, for scan ordering
+	std::vector<uint32_t> phase_end; // end of the phases of the process in the arena, 0 if it has none
+	std::vector<uint32_t> group; // in groups, always a leaf
+
+	/* The cpu and io phases of the processes which have them, one after the
+	 * other: cpu, io, cpu, ..., cpu. Processes without phases (burst bst,
+	 * with io of io ticks every quantum) take no room.
+	 */
+	std::vector<int32_t> phases;
+
+	group_tree_t groups; // only the root if the file has no groups
+
+	/* columns updated while the scheduler runs */
+	std::vector<size_t> Clock; // time when the process was pushed in the ready queue: ageing
+	std::vector<uint64_t> io_end; // time when the current IO completes, IO_QUEUED while waiting for the device
+	std::vector<int32_t> io_count; // number of times the process did IO: statistics
+	std::vector<uint64_t> io_total; // ticks of IO the process did: statistics
+	std::vector<uint64_t> switch_ticks; // ticks the cpu spent switching to the process: statistics
+	std::vector<uint64_t> cpu_ticks; // ticks of the clock the process ran on the cpu: statistics
+	std::vector<uint32_t> phase_next; // index in phases of the io after the current cpu phase
+	std::vector<int32_t> phase_left; // ticks left in the current cpu phase
+	std::vector<uint32_t> dispatches; // number of times the process got the cpu: statistics
+	std::vector<int32_t> base_bst; // Burst Time as read from the file: statistics
+	std::vector<uint8_t> base_pri; // Priority as read from the file: statistics
+	std::vector<uint64_t> start; // time when the process first got the cpu: statistics
+	std::vector<uint64_t> end; // time when the process terminated: statistics
+	std::vector<uint8_t> state; // proc_state_t: interactive view
+
+	void reserve(size_t n)
+	{
+		pid.reserve(n); bst.reserve(n); arr.reserve(n); pri.reserve(n);
+		dline.reserve(n); io.reserve(n); dev.reserve(n); pos.reserve(n); phase_end.reserve(n); group.reserve(n);
+		Clock.reserve(n); io_end.reserve(n); io_total.reserve(n); switch_ticks.reserve(n); cpu_ticks.reserve(n);
+		phase_next.reserve(n); phase_left.reserve(n);
+		io_count.reserve(n); dispatches.reserve(n); base_bst.reserve(n); base_pri.reserve(n);
+		start.reserve(n); end.reserve(n); state.reserve(n);
+	}
+
+	pidx_t add(int pid, int bst, int arr, int pri, int dline, int io, int dev=0, int pos=0)
+	{
+		this->pid.push_back(pid);
+		this->bst.push_back(bst);
+		this->arr.push_back(arr);
+		this->pri.push_back((uint8_t) pri);
+		this->dline.push_back(dline);
+		this->io.push_back(io);
+		this->dev.push_back(dev);
+		this->pos.push_back(pos);
+		phase_end.push_back(0);
+		group.push_back(ROOT_GROUP);
+
+		Clock.push_back(0);
+		io_end.push_back(0);
+		io_count.push_back(0);
+		io_total.push_back(0);
+		switch_ticks.push_back(0);
+		cpu_ticks.push_back(0);
+		phase_next.push_back(0);
+		phase_left.push_back(0);
+		dispatches.push_back(0);
+		base_bst.push_back(bst);
+		base_pri.push_back((uint8_t) pri);
+		start.push_back(NOT_STARTED);
+		end.push_back(NOT_ENDED);
+		state.push_back(ST_NEW);
+
+		return (pidx_t) (this->pid.size() - 1);
+	}
+
+	/* gives the process just added the phases p[0..n), n odd. It must
+	 * have been added with the total of the cpu phases as its burst.
+	 */
+	void add_phases(pidx_t x, const int32_t *p, size_t n)
+	{
+		phase_next[x] = (uint32_t) phases.size() + 1;
+		phase_left[x] = p[0];
+		phases.insert(phases.end(), p, p+n);
+		phase_end[x] = (uint32_t) phases.size();
+	}
+
+	bool has_phases(pidx_t x) const
+	{
+		return phase_end[x] != 0;
+	}
+
+	/* moves x on from a cpu phase which is over to the next one.
+	 * \retrun the ticks of io in between
+	 */
+	int32_t next_phase(pidx_t x)
+	{
+		int32_t io_len = phases[phase_next[x]];
+		phase_left[x] = phases[phase_next[x] + 1];
+		phase_next[x] += 2;
+		return io_len;
+	}
+
+	/* \retrun true if x has io left to do */
+	bool does_io(pidx_t x) const
+	{
+		return has_phases(x)? phase_next[x] < phase_end[x]: io[x] != 0;
+	}
+
+	/* \retrun the ticks of the io x is doing, or last did */
+	int32_t io_len(pidx_t x) const
+	{
+		return has_phases(x)? phases[phase_next[x] - 2]: io[x];
+	}
+
+	size_t size() const
+	{
+		return pid.size();
+	}
+
+	void print(pidx_t i) const
+	{
+		std::cerr << "pid: " << pid[i] << std::endl;
+		std::cerr << "bst: " << bst[i] << std::endl;
+		std::cerr << "arr: " << arr[i] << std::endl;
+		std::cerr << "pri: " << (int) pri[i] << std::endl;
+		std::cerr << "dline: " << dline[i] << std::endl;
+		std::cerr << "io: " << io[i] << std::endl;
+		std::cerr << "Clock: " << Clock[i] << std::endl;
 		std::cerr << std::endl;
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,366 @@
+#ifndef BANDWIDTH_H
+#define BANDWIDTH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "checkpoint.h"
+#include "PCB.h"
+
+#define NO_EVENT ((uint64_t) -1) // bandwidth_t::at while nothing is charged
+#define KERNEL_CLASS "kernel" // --cpu_quota of every kernel process
+#define USER_CLASS "user" // --cpu_quota of every user process
+
+/* one limit of --cpu_quota: quota ticks of cpu every period ticks for a
+ * class of processes or a group
+ */
+struct quota_spec_t
+{
+	std::string name; // KERNEL_CLASS, USER_CLASS or the path of a group
+	uint32_t quota;
+	uint32_t period;
+};
+
+/* statistics of one limit, for stats_t */
+struct bandwidth_stats_t
+{
+	std::string name;
+	uint32_t quota, period;
+	uint64_t periods; // periods in which it had cpu
+	uint64_t throttles; // times its quota was used up
+	uint64_t throttled; // ticks it was throttled
+};
+
+/* Cpu bandwidth control, like the cfs quota of cgroups. A limit gives a
+ * class of processes (kernel or user, by their priority) or a group,
+ * with the groups below it, quota ticks of cpu every period ticks,
+ * periods starting at the multiples of period. A process is under the
+ * limit of its class and those of its group and the groups above it.
+ * Once a limit has had its quota in a period it is throttled: the
+ * running process under it leaves the cpu and the processes under it
+ * are hidden in the ready queue (see group_ready_t::throttle()) until
+ * the next period.
+ *
+ * Nothing is done per tick. The running process is only charged when it
+ * leaves the cpu or at the clock at, when the first of its limits runs
+ * out or starts a new period; a throttled limit is an event in a heap on
+ * the clock its next period starts, and refresh() only pops those due.
+ * The ticks the cpu spends switching to a process count as its cpu.
+ */
+class bandwidth_t
+{
+private:
+	struct limit_t
+	{
+		uint32_t quota, period;
+		uint32_t group; // the group limited, NO_GROUP for a class
+		uint8_t kernel; // the class limited if not a group
+		uint8_t throttled;
+		uint64_t used; // ticks of cpu in the period
+		uint64_t period_no; // the period used is of
+		uint64_t since; // clock it was throttled at
+		uint64_t periods, throttles, throttled_ticks;
+
+		void save(snapshot_writer& w) const
+		{
+			w.put(quota);
+			w.put(period);
+			w.put(group);
+			w.put(kernel);
+			w.put(throttled);
+			w.put(used);
+			w.put(period_no);
+			w.put(since);
+			w.put(periods);
+			w.put(throttles);
+			w.put(throttled_ticks);
+		}
+
+		void load(snapshot_reader& r)
+		{
+			r.get(quota);
+			r.get(period);
+			r.get(group);
+			r.get(kernel);
+			r.get(throttled);
+			r.get(used);
+			r.get(period_no);
+			r.get(since);
+			r.get(periods);
+			r.get(throttles);
+			r.get(throttled_ticks);
+		}
+	};
+
+	struct event_t
+	{
+		uint64_t at; // clock the next period of the limit starts
+		uint32_t limit;
+
+		bool operator>(const event_t& o) const
+		{
+			return at > o.at || (at == o.at && limit > o.limit);
+		}
+
+		void save(snapshot_writer& w) const
+		{
+			w.put(at);
+			w.put(limit);
+		}
+
+		void load(snapshot_reader& r)
+		{
+			r.get(at);
+			r.get(limit);
+		}
+	};
+
+	std::vector<limit_t> limits;
+	std::vector<std::string> names; // of each limit
+	std::vector<std::vector<uint32_t> > under; // the limits of each slot
+	std::vector<uint32_t> slot; // of each process: 2 * its group + 1 if kernel
+	std::vector<event_t> events; // a heap, smallest at first
+	uint64_t since; // clock up to which the running process was charged
+	uint64_t at; // clock of its next event, NO_EVENT if it is not charged
+
+	/* starts the period of Clock, if it is a new one */
+	void roll(limit_t& l, uint64_t Clock)
+	{
+		if (l.period_no != Clock / l.period)
+		{
+			l.period_no = Clock / l.period;
+			l.used = 0;
+		}
+	}
+
+	template<typename F>
+	void throttle(uint32_t i, uint64_t Clock, F hide)
+	{
+		limit_t& l = limits[i];
+		l.throttled = 1;
+		l.since = Clock;
+		l.throttles++;
+		hide(l.group, l.kernel, true);
+
+		event_t e;
+		e.at = (l.period_no + 1) * l.period;
+		e.limit = i;
+		events.push_back(e);
+		std::push_heap(events.begin(), events.end(), std::greater<event_t>());
+	}
+
+public:
+	bandwidth_t()
+	{
+		since = 0;
+		at = NO_EVENT;
+	}
+
+	/* puts the processes of tbl under the limits of specs, whose groups must
+	 * be in tbl. is_kernel(x) tells the class of a process.
+	 */
+	template<typename F>
+	void configure(const proc_table_t& tbl, const std::vector<quota_spec_t>& specs, F is_kernel)
+	{
+		const group_tree_t& tree = tbl.groups;
+
+		if (specs.empty())
+			return;
+
+		limits.assign(specs.size(), limit_t());
+		names.clear();
+		for (size_t i=0; i!=specs.size(); i++)
+		{
+			limit_t& l = limits[i];
+			l.quota = specs[i].quota;
+			l.period = specs[i].period;
+			l.kernel = specs[i].name == KERNEL_CLASS;
+			l.group = l.kernel || specs[i].name == USER_CLASS? NO_GROUP: tree.find(specs[i].name);
+			names.push_back(specs[i].name);
+		}
+
+		under.assign(2 * tree.size(), std::vector<uint32_t>());
+		for (uint32_t g=0; g!=tree.size(); g++)
+			for (uint32_t kernel=0; kernel!=2; kernel++)
+				for (uint32_t i=0; i!=limits.size(); i++)
+				{
+					bool applies = limits[i].group == NO_GROUP && limits[i].kernel == kernel;
+					for (uint32_t up=g; up!=NO_GROUP && !applies; up=tree.parent[up])
+						applies = limits[i].group == up;
+					if (applies)
+						under[2*g + kernel].push_back(i);
+				}
+
+		slot.resize(tbl.size());
+		for (pidx_t x=0; x!=tbl.size(); x++)
+			slot[x] = 2 * tbl.group[x] + (is_kernel(x)? 1: 0);
+	}
+
+	bool active() const
+	{
+		return !limits.empty();
+	}
+
+	/* is any limit on a class rather than a group? */
+	bool by_class() const
+	{
+		for (const limit_t& l : limits)
+			if (l.group == NO_GROUP)
+				return true;
+		return false;
+	}
+
+	/* x got the cpu at Clock; it is charged from then on */
+	void dispatch(pidx_t x, size_t Clock)
+	{
+		since = Clock;
+		at = NO_EVENT;
+		if (active() && !under[slot[x]].empty())
+			arm(x);
+	}
+
+	/* is the running process charged? */
+	bool charging() const
+	{
+		return at != NO_EVENT;
+	}
+
+	/* \retrun true if the running process is due an event at Clock */
+	bool due(size_t Clock) const
+	{
+		return at <= Clock;
+	}
+
+	/* sets the clock of the next event of x, the running process: the
+	 * first clock a limit of it runs out, or ends its period
+	 */
+	void arm(pidx_t x)
+	{
+		at = NO_EVENT;
+		for (uint32_t i : under[slot[x]])
+		{
+			limit_t& l = limits[i];
+			roll(l, since + 1);
+			uint64_t end = (l.period_no + 1) * l.period - 1;
+			at = std::min(at, std::min(end, since + l.quota - l.used));
+		}
+	}
+
+	/* charges x, the running process, the ticks since it was last charged.
+	 * The limits which had their quota are throttled, calling
+	 * hide(group, kernel, true) for each.
+	 * \retrun true if any was throttled
+	 */
+	template<typename F>
+	bool charge(pidx_t x, size_t Clock, F hide)
+	{
+		uint64_t ticks = Clock - since;
+		bool out = false;
+
+		since = Clock;
+		for (uint32_t i : under[slot[x]])
+		{
+			limit_t& l = limits[i];
+			if (l.used == 0 && ticks != 0)
+				l.periods++;
+			l.used += ticks;
+			if (l.used >= l.quota && !l.throttled)
+			{
+				throttle(i, Clock, hide);
+				out = true;
+			}
+		}
+		return out;
+	}
+
+	/* the running process is not charged any more */
+	void stop()
+	{
+		at = NO_EVENT;
+	}
+
+	/* refreshes every throttled limit whose next period starts at Clock,
+	 * calling hide(group, kernel, false) for each
+	 */
+	template<typename F>
+	void refresh(size_t Clock, F hide)
+	{
+		while (!events.empty() && events.front().at <= Clock)
+		{
+			std::pop_heap(events.begin(), events.end(), std::greater<event_t>());
+			limit_t& l = limits[events.back().limit];
+			events.pop_back();
+
+			l.throttled = 0;
+			l.throttled_ticks += Clock - l.since;
+			hide(l.group, l.kernel, false);
+		}
+	}
+
+	/* calls hide(group, kernel, true) for every throttled limit, to hide
+	 * its processes in a new ready queue
+	 */
+	template<typename F>
+	void restore(F hide) const
+	{
+		for (const limit_t& l : limits)
+			if (l.throttled)
+				hide(l.group, l.kernel, true);
+	}
+
+	/* statistics of every limit, none without limits. A limit still
+	 * throttled is counted until the last time the cpu was charged.
+	 */
+	std::vector<bandwidth_stats_t> stats() const
+	{
+		std::vector<bandwidth_stats_t> all;
+		for (size_t i=0; i!=limits.size(); i++)
+		{
+			const limit_t& l = limits[i];
+			bandwidth_stats_t s;
+			s.name = names[i];
+			s.quota = l.quota;
+			s.period = l.period;
+			s.periods = l.periods;
+			s.throttles = l.throttles;
+			s.throttled = l.throttled_ticks + (l.throttled && since > l.since? since - l.since: 0);
+			all.push_back(s);
+		}
+		return all;
+	}
+
+	void save(snapshot_writer& w) const
+	{
+		w.put(since);
+		w.put(at);
+		w.put_each(limits);
+		w.put_each(events);
+	}
+
+	/* \retrun false if the state does not fit the limits configured */
+	bool load(snapshot_reader& r)
+	{
+		std::vector<limit_t> saved;
+
+		r.get(since);
+		r.get(at);
+		r.get_each(saved);
+		r.get_each(events);
+
+		if (saved.size() != limits.size())
+			return false;
+		for (size_t i=0; i!=saved.size(); i++)
+			if (saved[i].group != limits[i].group || saved[i].kernel != limits[i].kernel)
+				return false;
+		limits = saved;
+		for (const event_t& e : events)
+			if (e.limit >= limits.size())
+				return false;
+		return true;
+	}
+};
+
+#endif
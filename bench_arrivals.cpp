@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "proc_queues.h"
+
+#define BENCH_AGE_TIME 7 // ticks, so the ready queues keep their ageing lists
+#define BENCH_TICKS 10 // between two bursts
+#define BENCH_ROUNDS 5 // of each way, the fastest is kept
+
+/* the processes of a burst, arriving at the same tick */
+struct burst_t
+{
+	size_t Clock;
+	std::vector<pidx_t> procs;
+};
+
+/*************************************************************************/
+/*! This function makes a bursty table of processes: bursts of burst
+		processes arriving at the same tick, BENCH_TICKS apart, in four
+		groups, kernel and user apart.
+		\param tbl is the table the processes are added to
+		\param n is the number of processes
+		\param burst is the number of processes arriving at a tick
+		\retrun the bursts, in order of arrival
+*/
+/*************************************************************************/
+std::vector<burst_t> make_bursts(proc_table_t& tbl, size_t n, size_t burst)
+{
+	const char *paths[] = { "web", "db", "batch/a", "batch/b" };
+	uint32_t leaves[4];
+	std::vector<burst_t> bursts;
+
+	for (int i=0; i!=4; i++)
+		leaves[i] = tbl.groups.add_path(paths[i]);
+	tbl.groups.by_class = true;
+
+	srand(1);
+	tbl.reserve(n);
+	for (size_t i=0; i!=n; i++)
+	{
+		if (i % burst == 0)
+		{
+			bursts.push_back(burst_t());
+			bursts.back().Clock = (bursts.size() - 1) * BENCH_TICKS;
+		}
+		pidx_t x = tbl.add((int) i+1, rand()%19 + 1, (int) bursts.back().Clock, rand()%100, rand()%99 + 1, 0);
+		tbl.group[x] = leaves[rand()%4];
+		bursts.back().procs.push_back(x);
+	}
+	return bursts;
+}
+
+
+/*************************************************************************/
+/*! This function feeds the bursts to a ready queue as update() does, and
+		pops half of the queue after each, as if the scheduler ran meanwhile.
+		Only the pushes are timed.
+		\param tbl is the table of all processes
+		\param bursts is the processes arriving at each tick
+		\param bulk is whether a burst is pushed with push_bulk
+		\param order is given the processes in the order they popped
+		\retrun the nanoseconds spent pushing
+*/
+/*************************************************************************/
+template<typename R>
+double run_bursts(proc_table_t& tbl, const std::vector<burst_t>& bursts, bool bulk, std::vector<pidx_t>& order)
+{
+	R ready_q(tbl, BENCH_AGE_TIME, 1);
+	std::chrono::steady_clock::duration spent(0);
+
+	order.clear();
+	for (const burst_t& b : bursts)
+	{
+		for (pidx_t x : b.procs)
+		{
+			tbl.pri[x] = tbl.base_pri[x];
+			tbl.Clock[x] = tbl.pri[x] == 49 || tbl.pri[x] == 99? CLOCK_LAST: b.Clock;
+			tbl.state[x] = ST_READY;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		if (bulk)
+			ready_q.push_bulk(b.procs.begin(), b.procs.end());
+		else
+			for (pidx_t x : b.procs)
+				ready_q.push(x);
+		spent += std::chrono::steady_clock::now() - start;
+
+		for (size_t k=ready_q.size()/2; k!=0; k--)
+		{
+			order.push_back(ready_q.top());
+			ready_q.pop();
+		}
+	}
+	for (; !ready_q.empty(); ready_q.pop())
+		order.push_back(ready_q.top());
+
+	return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(spent).count();
+}
+
+
+/*************************************************************************/
+/*! This function times a ready queue both ways, taking turns for
+		BENCH_ROUNDS rounds, and prints the cost of an arrival in the fastest
+		round of each. It stops the program if the queue pops in another
+		order.
+		\param name is the name of the ready queue
+		\param tbl is the table of all processes
+		\param bursts is the processes arriving at each tick
+*/
+/*************************************************************************/
+template<typename R>
+void bench(const std::string& name, proc_table_t& tbl, const std::vector<burst_t>& bursts)
+{
+	std::vector<pidx_t> one, bulk;
+	double n = (double) tbl.size();
+	double t1 = 0, tb = 0;
+
+	for (int round=0; round!=BENCH_ROUNDS; round++)
+	{
+		double t = run_bursts<R>(tbl, bursts, false, one) / n;
+		t1 = round == 0? t: std::min(t1, t);
+		t = run_bursts<R>(tbl, bursts, true, bulk) / n;
+		tb = round == 0? t: std::min(tb, t);
+
+		if (one != bulk)
+		{
+			std::cerr << "The " << name << " queue pops in another order after push_bulk" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	printf("%-18s %10.1f %10.1f %8.2fx\n", name.c_str(), t1, tb, t1 / tb);
+}
+
+
+/*************************************************************************/
+/*! Times the ingestion of arrivals by the ready queues, one push per
+		process against a push_bulk per tick, on a bursty table of processes.
+		usage: ./bench_arrivals [<processes> [<burst>]]
+*/
+/*************************************************************************/
+int main(int argc, char *argv[])
+{
+	if (argc > 3)
+	{
+		std::cerr << "usage: " << argv[0] << " [<processes> [<burst>]]" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	long n = argc > 1? strtol(argv[1], NULL, 10): 200000;
+	long burst = argc > 2? strtol(argv[2], NULL, 10): 20000;
+	if (n <= 0 || burst <= 0)
+	{
+		std::cerr << "There must be at least a process in a burst" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	proc_table_t tbl;
+	std::vector<burst_t> bursts = make_bursts(tbl, (size_t) n, (size_t) burst);
+
+	printf("%ld processes, %ld a tick\n", n, burst);
+	printf("%-18s %10s %10s %9s\n", "queue", "push ns", "bulk ns", "speedup");
+	bench<ready_age_t<fifo_t> >("fifo", tbl, bursts);
+	bench<ready_age_t<sjf_t> >("sjf", tbl, bursts);
+	bench<ready_age_t<priority_t> >("priority", tbl, bursts);
+	bench<ready_age_t<edf_t> >("edf", tbl, bursts);
+	bench<lazy_ready_t>("priority lazy", tbl, bursts);
+	bench<group_ready_t<ready_age_t<priority_t> > >("priority grouped", tbl, bursts);
+	bench<group_ready_t<lazy_ready_t> >("lazy grouped", tbl, bursts);
+	return 0;
+}
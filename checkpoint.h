@@ -0,0 +1,136 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <string>
+#include <vector>
+
+#define CHECKPOINT_MAGIC 0x3631504b43535350ULL // "PSSCKP16"
+
+/* Binary writer for checkpoint files. Values are written in the native
+ * layout of the machine, so a checkpoint is only meant to be resumed by
+ * the same build. The file is written to <name>.tmp and renamed over
+ * <name> on commit() so a crash while saving keeps the last checkpoint.
+ */
+class snapshot_writer
+{
+private:
+	std::ofstream os;
+	std::string name;
+
+public:
+	bool open(const std::string& name)
+	{
+		this->name = name;
+		os.open((name + ".tmp").c_str(), std::ios::binary | std::ios::trunc);
+		return os.is_open();
+	}
+
+	template<typename T>
+	void put(const T& val)
+	{
+		os.write((const char*) &val, sizeof(T));
+	}
+
+	/* a vector of T written as is, for T with no padding */
+	template<typename T>
+	void put(const std::vector<T>& vec)
+	{
+		put((uint64_t) vec.size());
+		os.write((const char*) vec.data(), vec.size() * sizeof(T));
+	}
+
+	/* a vector of structs, each written field by field by its save(), so
+	 * their padding is not written
+	 */
+	template<typename T>
+	void put_each(const std::vector<T>& vec)
+	{
+		put((uint64_t) vec.size());
+		for (const T& item : vec)
+			item.save(*this);
+	}
+
+	template<typename T>
+	void put(const std::list<T>& lst)
+	{
+		put(std::vector<T>(lst.begin(), lst.end()));
+	}
+
+	bool commit()
+	{
+		os.close();
+		if (os.fail())
+			return false;
+		return std::rename((name + ".tmp").c_str(), name.c_str()) == 0;
+	}
+};
+
+/* Binary reader matching snapshot_writer. Reading past the end or a
+ * corrupt length leaves the reader in the failed state, see good().
+ */
+class snapshot_reader
+{
+private:
+	std::ifstream is;
+
+public:
+	bool open(const std::string& name)
+	{
+		is.open(name.c_str(), std::ios::binary);
+		return is.is_open();
+	}
+
+	template<typename T>
+	void get(T& val)
+	{
+		is.read((char*) &val, sizeof(T));
+	}
+
+	template<typename T>
+	void get(std::vector<T>& vec)
+	{
+		uint64_t n = 0;
+		get(n);
+		if (!is.good() || n > ((uint64_t) 1 << 40) / sizeof(T))
+		{
+			is.setstate(std::ios::failbit);
+			return;
+		}
+		vec.resize(n);
+		is.read((char*) vec.data(), n * sizeof(T));
+	}
+
+	template<typename T>
+	void get_each(std::vector<T>& vec)
+	{
+		uint64_t n = 0;
+		get(n);
+		if (!is.good() || n > ((uint64_t) 1 << 40) / sizeof(T))
+		{
+			is.setstate(std::ios::failbit);
+			return;
+		}
+		vec.resize(n);
+		for (T& item : vec)
+			item.load(*this);
+	}
+
+	template<typename T>
+	void get(std::list<T>& lst)
+	{
+		std::vector<T> vec;
+		get(vec);
+		lst.assign(vec.begin(), vec.end());
+	}
+
+	bool good() const
+	{
+		return is.good();
+	}
+};
+
+#endif
@@ -1,60 +1,50 @@
 #include "cl_parser.h"
 #include <assert.h>
 
-typedef std::vector<CLParser::pair_t>::const_iterator parser_vec_iter_t;
-
 /* local split member function */
-CLParser::pair_t 
-CLParser::split(std::string input, std::string token)
+std::pair<std::string, std::string>
+CLParser::split(const std::string &input, const std::string &token)
 {
-  CLParser::pair_t pair;
-  size_t pos;
-
-	/* get the option name */
-  pos = input.find(token);
-  pair.option = input.substr(0, pos);
-
-  /* if option has value, get it */
-  if (pos != std::string::npos)
-		pair.value = input.substr(pos+token.size(), std::string::npos);
-	else
-		pair.value = std::string("");
+	size_t pos = input.find(token);
 
-	/* return the pair */
-	return pair;
+	/* get the option name, and its value if it has one */
+	if (pos == std::string::npos)
+		return std::make_pair(input, std::string(""));
+	return std::make_pair(input.substr(0, pos), input.substr(pos+token.size()));
 }
 
+/* argv[0] is the program, not an option */
 CLParser::CLParser(int &argc, char **argv)
 {
 	std::string token = "=";
 
-	for (int i=0; i!=argc; i++)
-	{
-		std::string arg(argv[i]);
-		pairs.push_back(split(arg, token));
-	}
+	for (int i=1; i<argc; i++)
+		pairs.insert(split(std::string(argv[i]), token));
 }
 
 bool
 CLParser::optionExists(const std::string &option) const
 {
-	parser_vec_iter_t iter = pairs.begin();
-	for (iter=pairs.begin(); iter!=pairs.end(); iter++)
-		if (iter->option.compare(option) == 0)
-			return true;
-
-	return false;
+	return pairs.find(option) != pairs.end();
 }
 
 std::string
 CLParser::optionValue(const std::string &option) const
 {
-	parser_vec_iter_t iter;
-	for (iter=pairs.begin(); iter!=pairs.end(); iter++)
-		if (iter->option.compare(option) == 0)
-			return iter->value;
+	const_iterator iter = pairs.find(option);
+	if (iter != pairs.end())
+		return iter->second;
 
 	/* it is assumed that the option is always found */
 	assert(false);
 	return std::string(""); // to avoid compiler errors
-}
\ No newline at end of file
+}
+
+/* adds option unless it was given already.
+ * returns false if it was
+ */
+bool
+CLParser::addOption(const std::string &option, const std::string &value)
+{
+	return pairs.insert(std::make_pair(option, value)).second;
+}
@@ -1,25 +1,28 @@
 #ifndef CL_PARSER_H
 #define CL_PARSER_H
 
-#include <algorithm>
+#include <map>
 #include <string>
-#include <vector>
 
+/* The options of the command line, --name[=value], looked up by name.
+ * The first time an option is given wins; so do the options of the
+ * command line over those added from a config file after it.
+ */
 class CLParser
 {
 private: 
-	struct pair_t 
-	{
-		std::string option;
-		std::string value;
-	};
-	std::vector<pair_t> pairs;
+	std::map<std::string, std::string> pairs; // option to value, "" if it has none
 
-	pair_t split(std::string input, std::string token);
+	static std::pair<std::string, std::string> split(const std::string &input, const std::string &token);
 public:
+	typedef std::map<std::string, std::string>::const_iterator const_iterator;
+
 	CLParser (int &argc, char **argv);
 	bool optionExists(const std::string &option) const;
 	std::string optionValue(const std::string &option) const;
+	bool addOption(const std::string &option, const std::string &value);
+	const_iterator begin() const { return pairs.begin(); }
+	const_iterator end() const { return pairs.end(); }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,252 @@
+#ifndef DVFS_H
+#define DVFS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "checkpoint.h"
+#include "PCB.h"
+
+#define DEFAULT_CPU_LEVELS "1000:250:40,2000:900:70,3000:2400:100" // <mhz>:<busy-mW>:<idle-mW>,...
+#define DEFAULT_GOVERNOR_SAMPLE 10 // ticks between the ondemand governor's looks at the load
+#define UP_THRESHOLD 80 // load, in percent, above which ondemand goes to the top frequency
+
+/* the governor picking the frequency of the cpu, GOV_NONE for no
+ * frequency model at all: every tick of cpu is a tick of burst
+ */
+enum governor_t
+{
+	GOV_NONE,
+	GOV_PERFORMANCE,
+	GOV_POWERSAVE,
+	GOV_ONDEMAND,
+	GOVERNORS
+};
+
+static const char *const governor_name[GOVERNORS] =
+{
+	"none",
+	"performance",
+	"powersave",
+	"ondemand"
+};
+
+/* a frequency the cpu can run at, and the power it draws at it */
+struct cpu_level_t
+{
+	uint32_t mhz;
+	uint32_t busy_mw; // while running a process or switching
+	uint32_t idle_mw; // while the cpu has nothing to run
+};
+
+/* statistics of the frequency model, for stats_t */
+struct dvfs_stats_t
+{
+	governor_t governor;
+	std::vector<cpu_level_t> levels;
+	std::vector<uint64_t> busy; // ticks busy at each level
+	std::vector<uint64_t> idle; // ticks idle at each level
+	uint64_t changes; // of frequency
+
+	dvfs_stats_t()
+	{
+		governor = GOV_NONE;
+		changes = 0;
+	}
+
+	/* \retrun the energy of the run, taking a tick as a millisecond */
+	double energy_mj() const
+	{
+		double mj = 0.0;
+		for (size_t i=0; i!=levels.size(); i++)
+			mj += (busy[i] * (double) levels[i].busy_mw + idle[i] * (double) levels[i].idle_mw) / 1000.0;
+		return mj;
+	}
+
+	uint64_t ticks() const
+	{
+		uint64_t n = 0;
+		for (size_t i=0; i!=levels.size(); i++)
+			n += busy[i] + idle[i];
+		return n;
+	}
+};
+
+/* Frequency scaling of the cpu, with a power model. The levels are
+ * sorted by frequency, the last being the top one. Bursts are in ticks
+ * at the top frequency: a tick at a lower one only does part of a tick
+ * of burst, so the process keeps what it did, in MHz-ticks, in work and
+ * its burst goes down a tick each time work adds up to the top MHz.
+ * Quanta, io and deadlines stay in ticks of the clock.
+ *
+ * performance keeps the top frequency, powersave the lowest. ondemand
+ * looks at the load of the last sample ticks every sample ticks: above
+ * UP_THRESHOLD it goes to the top frequency, otherwise to the lowest one
+ * which would have kept the load at UP_THRESHOLD, like the ondemand
+ * governor of Linux. Each tick draws the busy or idle power of its level.
+ */
+class dvfs_t
+{
+private:
+	governor_t governor;
+	uint32_t sample;
+	std::vector<cpu_level_t> levels;
+	uint32_t level; // index of the frequency the cpu runs at
+	uint32_t window; // busy ticks since the governor last looked
+	uint64_t changes;
+	std::vector<uint64_t> busy, idle; // ticks at each level
+	std::vector<uint32_t> work; // of each process: MHz-ticks done towards its next tick of burst
+
+	uint32_t top() const
+	{
+		return levels.back().mhz;
+	}
+
+	/* the ondemand governor picks the level of the next sample ticks */
+	void govern()
+	{
+		uint32_t load = (uint32_t) (100ULL * window / sample);
+		uint32_t next = (uint32_t) levels.size() - 1;
+
+		if (load < UP_THRESHOLD)
+		{
+			uint64_t want = (uint64_t) levels[level].mhz * load / UP_THRESHOLD;
+			for (next=0; levels[next].mhz < want; next++)
+				;
+		}
+		if (next != level)
+		{
+			level = next;
+			changes++;
+		}
+	}
+
+public:
+	dvfs_t()
+	{
+		governor = GOV_NONE;
+		sample = DEFAULT_GOVERNOR_SAMPLE;
+		level = 0;
+		window = 0;
+		changes = 0;
+	}
+
+	/* levels must be sorted by frequency, none twice. Nothing is modelled
+	 * with GOV_NONE.
+	 */
+	void configure(governor_t governor, const std::vector<cpu_level_t>& levels, uint32_t sample, size_t procs)
+	{
+		if (governor == GOV_NONE || levels.empty())
+			return;
+
+		this->governor = governor;
+		this->levels = levels;
+		this->sample = sample;
+		level = governor == GOV_POWERSAVE? 0: (uint32_t) levels.size() - 1;
+		busy.assign(levels.size(), 0);
+		idle.assign(levels.size(), 0);
+		work.assign(procs, 0);
+	}
+
+	bool active() const
+	{
+		return governor != GOV_NONE;
+	}
+
+	uint32_t mhz() const
+	{
+		return active()? levels[level].mhz: 0;
+	}
+
+	/* x runs a tick of the clock.
+	 * \retrun true if it did a tick of its burst
+	 */
+	bool run(pidx_t x)
+	{
+		if (!active())
+			return true;
+
+		work[x] += levels[level].mhz;
+		if (work[x] < top())
+			return false;
+		work[x] -= top();
+		return true;
+	}
+
+	/* \retrun the ticks x would take to run bst ticks of burst at the
+	 * frequency of now
+	 */
+	uint64_t ticks(pidx_t x, int32_t bst) const
+	{
+		if (!active())
+			return bst;
+
+		uint64_t left = (uint64_t) bst * top() - work[x];
+		return (left + levels[level].mhz - 1) / levels[level].mhz;
+	}
+
+	/* accounts for the tick Clock, busy or idle, and lets the governor
+	 * pick the frequency of the next one
+	 */
+	void tick(bool busy, size_t Clock)
+	{
+		if (!active())
+			return;
+
+		if (busy)
+		{
+			this->busy[level]++;
+			window++;
+		}
+		else
+			idle[level]++;
+
+		if (governor == GOV_ONDEMAND && (Clock + 1) % sample == 0)
+		{
+			govern();
+			window = 0;
+		}
+	}
+
+	/* statistics of the run, governor GOV_NONE without a model */
+	dvfs_stats_t stats() const
+	{
+		dvfs_stats_t s;
+		s.governor = governor;
+		s.levels = levels;
+		s.busy = busy;
+		s.idle = idle;
+		s.changes = changes;
+		return s;
+	}
+
+	void save(snapshot_writer& w) const
+	{
+		w.put(level);
+		w.put(window);
+		w.put(changes);
+		w.put(busy);
+		w.put(idle);
+		w.put(work);
+	}
+
+	/* \retrun false if the state does not fit the levels configured */
+	bool load(snapshot_reader& r)
+	{
+		size_t procs = work.size();
+
+		r.get(level);
+		r.get(window);
+		r.get(changes);
+		r.get(busy);
+		r.get(idle);
+		r.get(work);
+
+		if (!active())
+			return busy.empty() && idle.empty() && work.empty();
+		return level < levels.size() && busy.size() == levels.size() && idle.size() == levels.size()
+					 && work.size() == procs;
+	}
+};
+
+#endif
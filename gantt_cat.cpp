@@ -0,0 +1,51 @@
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+
+#include "gantt_format.h"
+
+/*************************************************************************/
+/*! Prints a packed Gantt chart (--packed_output) as the text chart the
+		scheduler writes without it. The file is read as a stream, so it can
+		be piped into other tools whatever its size.
+		usage: ./gantt_cat <output-file>.gpk
+*/
+/*************************************************************************/
+int main(int argc, char *argv[])
+{
+	if (argc != 2)
+	{
+		std::cerr << "usage: " << argv[0] << " <packed-output-file>" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::ifstream in(argv[1], std::ios::binary);
+	if (!in)
+	{
+		std::cerr << "Could not open \'" << argv[1] << "\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	gantt_reader reader(in);
+	if (!reader.good())
+	{
+		std::cerr << "\'" << argv[1] << "\' is not a Gantt chart" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::ios::sync_with_stdio(false);
+	std::cout << GANTT_HEADER;
+
+	gantt_event_t e;
+	while (reader.next(e))
+		std::cout << e.Clock << "\t" << e.pid << "\t" << gantt_action_text[e.action] << "\n";
+
+	if (!reader.good())
+	{
+		std::cout.flush();
+		std::cerr << "\'" << argv[1] << "\' is cut short" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	return 0;
+}
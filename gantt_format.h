@@ -0,0 +1,241 @@
+#ifndef GANTT_FORMAT_H
+#define GANTT_FORMAT_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <string>
+
+/* The Gantt chart is written either as text, one "CLOCK\tPID\tACTION"
+ * line per event, or packed with --packed_output. A packed chart starts
+ * with GANTT_MAGIC, then each event is two varints:
+ *
+ *   (Clock - previous Clock) << 3 | action
+ *   zigzag(pid - previous pid)
+ *
+ * Clocks only go up, so the first one mostly fits a byte, and the pid
+ * of an event is often the one before it. A GANTT_RESTART byte, written
+ * at the start of each block of the index (gantt_index.h), sets the
+ * previous Clock and pid back to 0, so the chart can be read from there.
+ * A run resumed from a checkpoint carries on the deltas where they were,
+ * so its chart is the same, byte for byte, as that of a run never cut.
+ */
+#define GANTT_HEADER "CLOCK\tPID\tACTION\n" // first line of a text chart
+#define GANTT_MAGIC "PSSGANT1"
+#define GANTT_MAGIC_LEN 8
+#define PACKED_EXT ".gpk" // added to the name of packed output files
+#define GANTT_RESTART 7
+
+enum gantt_action_t
+{
+	GANTT_GETS_CPU,
+	GANTT_END,
+	GANTT_TQ_INTER,
+	GANTT_IO_INTER,
+	GANTT_THROTTLED,
+	GANTT_ACTIONS
+};
+
+static const char *const gantt_action_text[GANTT_ACTIONS] =
+{
+	"Gets CPU",
+	"End",
+	"Clock Interrupt",
+	"I/O Interrupt",
+	"Throttled"
+};
+
+/* one line of the Gantt chart */
+struct gantt_event_t
+{
+	uint64_t Clock;
+	int32_t pid;
+	uint8_t action;
+};
+
+/* appends v to buf 7 bits at a time, low bits first */
+inline void put_varint(std::string& buf, uint64_t v)
+{
+	while (v >= 0x80)
+	{
+		buf.push_back((char) (v | 0x80));
+		v >>= 7;
+	}
+	buf.push_back((char) v);
+}
+
+/* packs events into the format above */
+class gantt_encoder
+{
+private:
+	uint64_t last_clock;
+	int32_t last_pid;
+
+public:
+	gantt_encoder()
+	{
+		restart();
+	}
+
+	void restart()
+	{
+		last_clock = 0;
+		last_pid = 0;
+	}
+
+	void put(std::string& buf, const gantt_event_t& e)
+	{
+		int64_t d = (int64_t) e.pid - last_pid;
+		put_varint(buf, (e.Clock - last_clock) << 3 | e.action);
+		put_varint(buf, ((uint64_t) d << 1) ^ (uint64_t) (d >> 63));
+		last_clock = e.Clock;
+		last_pid = e.pid;
+	}
+
+	/* written by the writer at each block of the index */
+	void put_restart(std::string& buf)
+	{
+		buf.push_back((char) GANTT_RESTART);
+		restart();
+	}
+
+	/* the Clock and pid the next event is a delta of */
+	void state(uint64_t& clock, int32_t& pid) const
+	{
+		clock = last_clock;
+		pid = last_pid;
+	}
+
+	/* carries on from the state of another encoder, at a checkpoint */
+	void resume(uint64_t clock, int32_t pid)
+	{
+		last_clock = clock;
+		last_pid = pid;
+	}
+};
+
+/* reads a chart, text or packed, one event at a time without loading
+ * the file
+ */
+class gantt_reader
+{
+private:
+	std::streambuf *sb;
+	bool packed;
+	uint64_t last_clock;
+	int32_t last_pid;
+	bool bad;
+
+	bool get_varint(uint64_t& v)
+	{
+		v = 0;
+		for (int shift=0; shift<64; shift+=7)
+		{
+			int c = sb->sbumpc();
+			if (c == std::char_traits<char>::eof())
+				return false;
+			v |= (uint64_t) (c & 0x7f) << shift;
+			if (!(c & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	bool next_packed(gantt_event_t& e)
+	{
+		uint64_t v, z;
+
+		do
+		{
+			if (sb->sgetc() == std::char_traits<char>::eof())
+				return false;
+			if (!get_varint(v))
+				return !(bad = true);
+			if (v == GANTT_RESTART)
+			{
+				last_clock = 0;
+				last_pid = 0;
+			}
+		} while (v == GANTT_RESTART);
+
+		if (!get_varint(z) || (v & 7) >= GANTT_ACTIONS)
+			return !(bad = true);
+
+		last_clock += v >> 3;
+		last_pid = (int32_t) ((int64_t) last_pid + (int64_t) ((z >> 1) ^ -(z & 1)));
+		e.Clock = last_clock;
+		e.pid = last_pid;
+		e.action = (uint8_t) (v & 7);
+		return true;
+	}
+
+	bool next_text(gantt_event_t& e)
+	{
+		std::string line;
+		int c;
+
+		if (sb->sgetc() == std::char_traits<char>::eof())
+			return false;
+		while ((c = sb->sbumpc()) != std::char_traits<char>::eof() && c != '\n')
+			line.push_back((char) c);
+
+		size_t tab1 = line.find('\t');
+		size_t tab2 = line.find('\t', tab1+1);
+		if (tab1 == 0 || tab1 == std::string::npos || tab2 == std::string::npos)
+			return !(bad = true);
+
+		e.Clock = std::strtoull(line.c_str(), NULL, 10);
+		e.pid = (int32_t) std::strtol(line.c_str() + tab1+1, NULL, 10);
+		for (e.action=0; e.action!=GANTT_ACTIONS; e.action++)
+			if (line.compare(tab2+1, std::string::npos, gantt_action_text[e.action]) == 0)
+				return true;
+		return !(bad = true);
+	}
+
+public:
+	/* \param is is the chart, opened in binary mode */
+	gantt_reader(std::istream& is)
+	{
+		std::string head(sizeof(GANTT_HEADER) - 1, '\0');
+
+		sb = is.rdbuf();
+		last_clock = 0;
+		last_pid = 0;
+		packed = sb->sgetn(&head[0], GANTT_MAGIC_LEN) == GANTT_MAGIC_LEN
+			&& head.compare(0, GANTT_MAGIC_LEN, GANTT_MAGIC) == 0;
+		bad = false;
+		if (!packed)
+			bad = sb->sgetn(&head[GANTT_MAGIC_LEN], head.size() - GANTT_MAGIC_LEN)
+				!= (std::streamsize) (head.size() - GANTT_MAGIC_LEN) || head != GANTT_HEADER;
+	}
+
+	/* \retrun false if the stream is not a chart, or is cut short (see next) */
+	bool good() const
+	{
+		return !bad;
+	}
+
+	bool is_packed() const
+	{
+		return packed;
+	}
+
+	/* carry on reading at offset, the start of a block of the index */
+	void seek(uint64_t offset)
+	{
+		if (sb->pubseekpos(offset) != std::streampos(offset))
+			bad = true;
+		last_clock = 0;
+		last_pid = 0;
+	}
+
+	/* \retrun false at the end of the chart, or if it is cut short */
+	bool next(gantt_event_t& e)
+	{
+		if (bad)
+			return false;
+		return packed? next_packed(e): next_text(e);
+	}
+};
+
+#endif
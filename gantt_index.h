@@ -0,0 +1,189 @@
+#ifndef GANTT_INDEX_H
+#define GANTT_INDEX_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "checkpoint.h"
+#include "gantt_format.h"
+
+/* Sidecar index of a Gantt chart, written to <output-file>.idx with
+ * --index_output. The chart is cut into blocks of GANTT_BLOCK events;
+ * a packed chart restarts its deltas at each block, so either kind can
+ * be read from the start of any block. The index holds
+ *
+ *   blocks    the first Clock, file offset and process on the cpu at the
+ *             start of every block, in order, to find a clock
+ *   postings  (pid, block) for every block a pid has events in, sorted
+ *             by pid, to find the life of a process
+ *
+ * so both are a binary search and the reading of a few blocks.
+ */
+#define GANTT_INDEX_MAGIC 0x3158444954535350ULL // "PSSTIDX1"
+#define GANTT_BLOCK 4096
+#define GANTT_NO_PID INT32_MIN // no process on the cpu
+
+struct gantt_block_t
+{
+	uint64_t Clock; // of the first event
+	uint64_t offset;
+	int32_t running; // before the first event
+	uint32_t pad;
+};
+
+struct gantt_posting_t
+{
+	int32_t pid;
+	uint32_t block;
+
+	bool operator<(const gantt_posting_t& o) const
+	{
+		return pid < o.pid || (pid == o.pid && block < o.block);
+	}
+};
+
+/* builds the index as the chart is written, see gantt_writer */
+class gantt_indexer
+{
+private:
+	std::vector<gantt_block_t> blocks;
+	std::vector<gantt_posting_t> postings; // in the order they were found
+	std::unordered_map<int32_t, uint32_t> last; // last block of each pid
+	uint64_t events;
+	int32_t running;
+
+public:
+	gantt_indexer()
+	{
+		events = 0;
+		running = GANTT_NO_PID;
+	}
+
+	/* \retrun true if the next event is the first of a block */
+	bool starts_block() const
+	{
+		return events % GANTT_BLOCK == 0;
+	}
+
+	/* \param offset is where e starts in the chart */
+	void add(const gantt_event_t& e, uint64_t offset)
+	{
+		if (starts_block())
+		{
+			gantt_block_t b;
+			b.Clock = e.Clock;
+			b.offset = offset;
+			b.running = running;
+			b.pad = 0;
+			blocks.push_back(b);
+		}
+		events++;
+
+		uint32_t block = (uint32_t) (blocks.size() - 1);
+		auto iter = last.find(e.pid);
+		if (iter == last.end() || iter->second != block)
+		{
+			gantt_posting_t p;
+			p.pid = e.pid;
+			p.block = block;
+			postings.push_back(p);
+			last[e.pid] = block;
+		}
+
+		if (e.action == GANTT_GETS_CPU)
+			running = e.pid;
+		else if (e.pid == running)
+			running = GANTT_NO_PID;
+	}
+
+	/* writes the index. \retrun false if it could not */
+	bool save(const std::string& name, bool packed) const
+	{
+		snapshot_writer w;
+		std::vector<gantt_posting_t> sorted(postings);
+
+		std::sort(sorted.begin(), sorted.end());
+		if (!w.open(name))
+			return false;
+		w.put((uint64_t) GANTT_INDEX_MAGIC);
+		w.put((uint64_t) packed);
+		w.put(blocks);
+		w.put(sorted);
+		return w.commit();
+	}
+
+	/* the state of the indexer goes in the checkpoints, so a resumed run
+	 * carries on the same index
+	 */
+	void save_state(snapshot_writer& w) const
+	{
+		w.put(events);
+		w.put(running);
+		w.put(blocks);
+		w.put(postings);
+	}
+
+	void load_state(snapshot_reader& r)
+	{
+		r.get(events);
+		r.get(running);
+		r.get(blocks);
+		r.get(postings);
+
+		last.clear();
+		for (const gantt_posting_t& p : postings)
+			last[p.pid] = p.block;
+	}
+};
+
+/* the index as read by the query tool */
+struct gantt_index
+{
+	bool packed;
+	std::vector<gantt_block_t> blocks;
+	std::vector<gantt_posting_t> postings;
+
+	/* \retrun false if name is not an index */
+	bool load(const std::string& name)
+	{
+		snapshot_reader r;
+		uint64_t magic = 0, p = 0;
+
+		if (!r.open(name))
+			return false;
+		r.get(magic);
+		r.get(p);
+		r.get(blocks);
+		r.get(postings);
+		packed = p != 0;
+		return r.good() && magic == GANTT_INDEX_MAGIC;
+	}
+
+	/* \retrun the block from which to read to see every event at Clock */
+	size_t block_of(uint64_t Clock) const
+	{
+		auto iter = std::lower_bound(blocks.begin(), blocks.end(), Clock,
+			[](const gantt_block_t& b, uint64_t c) { return b.Clock < c; });
+		return iter == blocks.begin()? 0: iter - blocks.begin() - 1;
+	}
+
+	/* \retrun the blocks with events of pid, in order */
+	std::vector<uint32_t> blocks_of(int32_t pid) const
+	{
+		std::vector<uint32_t> found;
+		gantt_posting_t key;
+		key.pid = pid;
+		key.block = 0;
+
+		for (auto iter=std::lower_bound(postings.begin(), postings.end(), key);
+				 iter!=postings.end() && iter->pid == pid; iter++)
+			found.push_back(iter->block);
+		return found;
+	}
+};
+
+#endif
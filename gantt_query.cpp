@@ -0,0 +1,117 @@
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+
+#include "gantt_format.h"
+#include "gantt_index.h"
+
+#define PRINT_EVENT(e) (std::cout << (e).Clock << "\t" << (e).pid << "\t" << gantt_action_text[(e).action] << std::endl)
+
+/*************************************************************************/
+/*! This functions prints the events at Clock and the process on the cpu
+		once they are done. Only the block holding Clock, and the one before
+		it, are read.
+		\param idx is the index of the chart
+		\param reader is the chart
+		\param Clock is the clock to look at
+*/
+/*************************************************************************/
+void query_clock(const gantt_index& idx, gantt_reader& reader, uint64_t Clock)
+{
+	gantt_event_t e;
+	int32_t running = GANTT_NO_PID;
+
+	if (!idx.blocks.empty())
+	{
+		const gantt_block_t& b = idx.blocks[idx.block_of(Clock)];
+		running = b.running;
+		reader.seek(b.offset);
+	}
+
+	std::cout << GANTT_HEADER;
+	while (reader.next(e) && e.Clock <= Clock)
+	{
+		if (e.Clock == Clock)
+			PRINT_EVENT(e);
+		if (e.action == GANTT_GETS_CPU)
+			running = e.pid;
+		else if (e.pid == running)
+			running = GANTT_NO_PID;
+	}
+
+	if (running == GANTT_NO_PID)
+		std::cout << "at clock " << Clock << " the cpu is idle" << std::endl;
+	else
+		std::cout << "at clock " << Clock << " pid " << running << " has the cpu" << std::endl;
+}
+
+
+/*************************************************************************/
+/*! This functions prints every event of pid, reading only the blocks
+		it has events in.
+		\param idx is the index of the chart
+		\param reader is the chart
+		\param pid is the process to look at
+*/
+/*************************************************************************/
+void query_pid(const gantt_index& idx, gantt_reader& reader, int32_t pid)
+{
+	gantt_event_t e;
+
+	std::cout << GANTT_HEADER;
+	for (uint32_t block : idx.blocks_of(pid))
+	{
+		reader.seek(idx.blocks[block].offset);
+		for (int n=0; n!=GANTT_BLOCK && reader.next(e); n++)
+			if (e.pid == pid)
+				PRINT_EVENT(e);
+	}
+}
+
+
+/*************************************************************************/
+/*! Answers questions about a Gantt chart written with --index_output,
+		text or packed, from its index (<output-file>.idx), without reading
+		the whole chart.
+		usage: ./gantt_query <output-file> clock <clock>
+		       ./gantt_query <output-file> pid <pid>
+*/
+/*************************************************************************/
+int main(int argc, char *argv[])
+{
+	if (argc != 4 || (std::string(argv[2]) != "clock" && std::string(argv[2]) != "pid"))
+	{
+		std::cerr << "usage: " << argv[0] << " <output-file> clock <clock>" << std::endl;
+		std::cerr << "       " << argv[0] << " <output-file> pid <pid>" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::string name = argv[1];
+	gantt_index idx;
+	if (!idx.load(name + ".idx"))
+	{
+		std::cerr << "Could not read the index \'" << name << ".idx\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::ifstream in(name.c_str(), std::ios::binary);
+	gantt_reader reader(in);
+	if (!in || !reader.good() || reader.is_packed() != idx.packed)
+	{
+		std::cerr << "\'" << name << "\' is not the Gantt chart of its index" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	if (std::string(argv[2]) == "clock")
+		query_clock(idx, reader, std::strtoull(argv[3], NULL, 10));
+	else
+		query_pid(idx, reader, (int32_t) std::strtol(argv[3], NULL, 10));
+
+	if (!reader.good())
+	{
+		std::cerr << "\'" << name << "\' is cut short" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	return 0;
+}
@@ -0,0 +1,285 @@
+#ifndef GANTT_WRITER_H
+#define GANTT_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gantt_format.h"
+#include "gantt_index.h"
+
+/* my implementation of a bounded single-producer single-consumer queue.
+ * The producer only ever stores tail and the consumer only ever stores
+ * head, so neither needs a lock. SIZE must be a power of two.
+ */
+template<typename T, size_t SIZE>
+class spsc_ring
+{
+private:
+	alignas(64) std::atomic<size_t> head; // next slot to read
+	alignas(64) std::atomic<size_t> tail; // next slot to write
+	std::vector<T> slots;
+
+public:
+	spsc_ring()
+		: head(0), tail(0), slots(SIZE)
+	{
+	}
+
+	/* producer side. \ret false if the ring is full */
+	bool try_push(const T& val)
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == SIZE)
+			return false;
+
+		slots[t & (SIZE-1)] = val;
+		tail.store(t+1, std::memory_order_release);
+		return true;
+	}
+
+	/* consumer side. \ret false if the ring is empty */
+	bool try_pop(T& val)
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return false;
+
+		val = slots[h & (SIZE-1)];
+		head.store(h+1, std::memory_order_release);
+		return true;
+	}
+};
+
+/* Writes the Gantt chart on its own thread. The scheduler only copies
+ * each event into a ring, and the writer thread formats and writes them
+ * in the same order, in large blocks, as text or packed (gantt_format.h).
+ * If the writer falls a whole ring behind, push() waits for it. Between
+ * start() and stop() nothing else may write to the stream; drain() hands
+ * it back up to date. If indexed, the index of the chart is built on the
+ * same thread, and may only be used while the writer is drained or
+ * stopped.
+ */
+class gantt_writer
+{
+private:
+	enum
+	{
+		RING_SIZE = 1 << 16,
+		BLOCK = 1 << 16 // bytes formatted before each write
+	};
+
+	typedef spsc_ring<gantt_event_t, RING_SIZE> ring_t;
+
+	ring_t *ring; // allocated on its own, see make_ring
+	std::ostream *os;
+	bool packed;
+	bool indexed;
+	uint64_t base; // offset of the stream at start()
+	uint64_t written; // bytes written since
+	gantt_encoder enc;
+	std::thread worker;
+	std::atomic<bool> stopping;
+	std::atomic<bool> flush_wanted;
+
+	/* \retrun a new ring on the cache lines its alignas asks for. Before
+	 * C++17 new only aligns to alignof(max_align_t), so the ring is not
+	 * a member: anything holding the writer can then be made with new.
+	 */
+	static ring_t *make_ring()
+	{
+		void *p = NULL;
+		if (posix_memalign(&p, alignof(ring_t), sizeof(ring_t)) != 0)
+			throw std::bad_alloc();
+		return new (p) ring_t;
+	}
+
+	static void append(std::string& buf, int64_t v)
+	{
+		char digits[20];
+		int n = 0;
+		uint64_t u = v < 0? -(uint64_t) v: (uint64_t) v;
+		do
+		{
+			digits[n++] = (char) ('0' + u % 10);
+			u /= 10;
+		} while (u);
+
+		if (v < 0)
+			buf.push_back('-');
+		while (n)
+			buf.push_back(digits[--n]);
+	}
+
+	void format(std::string& buf, const gantt_event_t& e)
+	{
+		if (packed)
+		{
+			enc.put(buf, e);
+			return;
+		}
+
+		append(buf, (int64_t) e.Clock);
+		buf.push_back('\t');
+		append(buf, e.pid);
+		buf.push_back('\t');
+		buf.append(gantt_action_text[e.action]);
+		buf.push_back('\n');
+	}
+
+	void run()
+	{
+		std::string buf;
+		gantt_event_t e;
+
+		buf.reserve(BLOCK + 64);
+		for (;;)
+		{
+			/* read before the ring, so all pushed before a drain() or stop() is written */
+			bool stop = stopping.load(std::memory_order_acquire);
+			bool flush = flush_wanted.load(std::memory_order_acquire);
+			bool idle = true;
+
+			while (ring->try_pop(e))
+			{
+				idle = false;
+				if (indexed)
+				{
+					if (packed && index.starts_block())
+						enc.put_restart(buf);
+					index.add(e, base + written + buf.size());
+				}
+
+				format(buf, e);
+				if (buf.size() >= BLOCK)
+				{
+					os->write(buf.data(), buf.size());
+					written += buf.size();
+					buf.clear();
+				}
+			}
+
+			if (!buf.empty())
+			{
+				os->write(buf.data(), buf.size());
+				written += buf.size();
+				buf.clear();
+			}
+
+			if (flush)
+			{
+				os->flush();
+				flush_wanted.store(false, std::memory_order_release);
+			}
+
+			if (stop)
+				break;
+			if (idle)
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+
+		os->flush();
+	}
+
+public:
+	gantt_indexer index;
+
+	gantt_writer()
+		: ring(make_ring()), os(NULL), packed(false), indexed(false), base(0), written(0),
+			stopping(false), flush_wanted(false)
+	{
+	}
+
+	~gantt_writer()
+	{
+		stop();
+		ring->~ring_t();
+		free(ring);
+	}
+
+	/* the first thing in a chart, before start() */
+	static void header(std::ostream& os, bool packed)
+	{
+		if (packed)
+			os.write(GANTT_MAGIC, GANTT_MAGIC_LEN);
+		else
+			os << GANTT_HEADER << std::flush;
+	}
+
+	void start(std::ostream& os, bool packed, bool indexed)
+	{
+		this->os = &os;
+		this->packed = packed;
+		this->indexed = indexed;
+		base = (uint64_t) os.tellp();
+		written = 0;
+		stopping.store(false);
+		flush_wanted.store(false);
+		worker = std::thread(&gantt_writer::run, this);
+	}
+
+	void push(uint64_t Clock, int32_t pid, gantt_action_t action)
+	{
+		gantt_event_t e;
+		e.Clock = Clock;
+		e.pid = pid;
+		e.action = (uint8_t) action;
+
+		while (!ring->try_push(e))
+			std::this_thread::yield();
+	}
+
+	/* waits until everything pushed is written and the stream flushed.
+	 * A packed chart can be cut and carried on at this point, with the
+	 * state of its encoder (see save_state).
+	 */
+	void drain()
+	{
+		if (!worker.joinable())
+			return;
+
+		flush_wanted.store(true, std::memory_order_release);
+		while (flush_wanted.load(std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+
+	/* the state of the encoder, while drained, so a run resumed from a
+	 * checkpoint packs the rest of the chart as if it had not stopped
+	 */
+	void save_state(snapshot_writer& w) const
+	{
+		uint64_t clock;
+		int32_t pid;
+		enc.state(clock, pid);
+		w.put(clock);
+		w.put(pid);
+	}
+
+	/* before start() */
+	void load_state(snapshot_reader& r)
+	{
+		uint64_t clock = 0;
+		int32_t pid = 0;
+		r.get(clock);
+		r.get(pid);
+		enc.resume(clock, pid);
+	}
+
+	/* drains and ends the writer thread */
+	void stop()
+	{
+		if (!worker.joinable())
+			return;
+
+		stopping.store(true, std::memory_order_release);
+		worker.join();
+	}
+};
+
+#endif
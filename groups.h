@@ -0,0 +1,125 @@
+#ifndef GROUPS_H
+#define GROUPS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#define ROOT_GROUP 0 // every process is in it, or in a group below it
+#define NO_GROUP ((uint32_t) -1) // parent of the root
+#define DEFAULT_SHARES 1024 // of a group not given --group_shares, as cpu.shares
+#define GROUP_STRIDE (1ULL << 24) // virtual time of a tick of cpu at 1 share
+
+/* The groups processes are run in, like cgroups: a tree named by paths,
+ * "web/api" being the group api in the group web. Each group has shares
+ * of the cpu its parent gets, split among the children which have ready
+ * processes (see group_ready_t). Only leaves hold processes: the
+ * processes of a group which also has subgroups are moved to its
+ * subgroup "." when the file is read.
+ *
+ * The virtual time of a group is the cpu it got, times GROUP_STRIDE
+ * over its shares; the child of least virtual time runs next. floor of
+ * a group is the virtual time of the child it last ran, where a child
+ * which was idle starts again, so it cannot save up cpu while idle.
+ * They are kept here, with the processes, so branches and checkpoints
+ * carry them.
+ */
+struct group_tree_t
+{
+	std::vector<std::string> name; // path from the root, "" for the root
+	std::vector<uint32_t> parent;
+	std::vector<uint32_t> children; // how many
+	std::vector<uint32_t> shares;
+	std::vector<uint64_t> vtime;
+	std::vector<uint64_t> floor;
+	std::map<std::string, uint32_t> by_name;
+	bool by_class; // the leaves queue kernel and user processes apart, see group_ready_t
+
+	group_tree_t()
+	{
+		by_class = false;
+		add("", NO_GROUP);
+	}
+
+	size_t size() const
+	{
+		return name.size();
+	}
+
+	bool is_leaf(uint32_t g) const
+	{
+		return children[g] == 0;
+	}
+
+	/* \retrun the group of path, NO_GROUP if none */
+	uint32_t find(const std::string& path) const
+	{
+		auto iter = by_name.find(path);
+		return iter == by_name.end()? NO_GROUP: iter->second;
+	}
+
+	/* \retrun false if path has an empty name in it */
+	static bool valid_path(const std::string& path)
+	{
+		return path.empty() || (path[0] != '/' && path[path.size()-1] != '/' 
+														&& path.find("//") == std::string::npos);
+	}
+
+	/* the group of path, added with the groups above it if missing.
+	 * \retrun NO_GROUP if the path is not valid
+	 */
+	uint32_t add_path(const std::string& path)
+	{
+		uint32_t g = ROOT_GROUP;
+
+		if (path.empty())
+			return ROOT_GROUP;
+		if (!valid_path(path))
+			return NO_GROUP;
+
+		for (size_t slash=path.find('/'); ; slash=path.find('/', slash+1))
+		{
+			std::string sub = path.substr(0, slash);
+			uint32_t child = find(sub);
+			g = child == NO_GROUP? add(sub, g): child;
+			if (slash == std::string::npos)
+				return g;
+		}
+	}
+
+	/* the subgroup "." of g, which holds its processes if it has children */
+	uint32_t own(uint32_t g)
+	{
+		return add_path(name[g].empty()? ".": name[g] + "/.");
+	}
+
+private:
+	uint32_t add(const std::string& path, uint32_t up)
+	{
+		by_name[path] = (uint32_t) size();
+		name.push_back(path);
+		parent.push_back(up);
+		children.push_back(0);
+		shares.push_back(DEFAULT_SHARES);
+		vtime.push_back(0);
+		floor.push_back(0);
+		if (up != NO_GROUP)
+			children[up]++;
+		return (uint32_t) (size() - 1);
+	}
+};
+
+/* statistics of one group, and of the groups below it, for stats_t */
+struct group_stats_t
+{
+	std::string name;
+	uint32_t shares;
+	uint64_t procs;
+	uint64_t ended; // terminated
+	uint64_t cpu; // ticks run
+	uint64_t wait; // of the terminated ones
+	uint64_t turnaround; // of the terminated ones
+};
+
+#endif
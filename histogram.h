@@ -0,0 +1,109 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/* my implementation of a log-linear (HDR style) histogram.
+ * Values below 2^SUB_BITS are counted exactly. Above that, every power
+ * of two is split into 2^SUB_BITS equally sized buckets, so a recorded
+ * value is off by at most 1/2^SUB_BITS (~3%) of itself. The memory used
+ * is fixed no matter how many values are recorded, which makes it usable
+ * as a streaming quantile sketch for multi-million process runs.
+ */
+class histogram
+{
+private:
+	enum
+	{
+		SUB_BITS = 5,
+		SUB_COUNT = 1 << SUB_BITS,
+		NBUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT
+	};
+
+	uint64_t counts[NBUCKETS];
+	uint64_t total;
+	uint64_t max_val;
+
+	/* index of the bucket holding v */
+	static int bucket_of(uint64_t v)
+	{
+		if (v < SUB_COUNT)
+			return (int) v;
+
+		int msb = 63 - __builtin_clzll(v); // msb >= SUB_BITS
+		int shift = msb - SUB_BITS;
+		return (shift + 1) * SUB_COUNT + (int) ((v >> shift) - SUB_COUNT);
+	}
+
+	/* largest value which maps to bucket b */
+	static uint64_t highest_of(int b)
+	{
+		if (b < SUB_COUNT)
+			return (uint64_t) b;
+
+		int shift = b / SUB_COUNT - 1;
+		uint64_t low = (uint64_t) (b % SUB_COUNT + SUB_COUNT) << shift;
+		return low + ((uint64_t) 1 << shift) - 1;
+	}
+
+public:
+	histogram()
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		memset(counts, 0, sizeof(counts));
+		total = 0;
+		max_val = 0;
+	}
+
+	void record(uint64_t v)
+	{
+		counts[bucket_of(v)]++;
+		total++;
+		if (v > max_val)
+			max_val = v;
+	}
+
+	uint64_t count() const
+	{
+		return total;
+	}
+
+	uint64_t max() const
+	{
+		return max_val;
+	}
+
+	/* \ret the value at quantile q in [0,1]. The bucket upper bound is
+	 *      returned, clipped to the largest recorded value.
+	 */
+	uint64_t quantile(double q) const
+	{
+		if (total == 0)
+			return 0;
+
+		uint64_t rank = (uint64_t) std::ceil(q * (double) total);
+		if (rank == 0)
+			rank = 1;
+
+		uint64_t seen = 0;
+		for (int b=0; b!=NBUCKETS; b++)
+		{
+			seen += counts[b];
+			if (seen >= rank)
+			{
+				uint64_t v = highest_of(b);
+				return v < max_val? v: max_val;
+			}
+		}
+
+		return max_val;
+	}
+};
+
+#endif
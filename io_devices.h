@@ -0,0 +1,331 @@
+#ifndef IO_DEVICES_H
+#define IO_DEVICES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <vector>
+
+#include "checkpoint.h"
+#include "PCB.h"
+
+#define IO_QUEUED ((uint64_t) -1) // proc_table_t::io_end of a process waiting for its device
+
+enum io_discipline_t
+{
+	IO_FIFO, // in the order the requests came
+	IO_SCAN // by position, sweeping up and down like a disk arm
+};
+
+/* statistics of one device, for stats_t */
+struct io_device_stats_t
+{
+	uint64_t requests; // served
+	uint64_t busy; // ticks serving
+	uint64_t wait; // ticks requests spent queued
+	uint64_t area; // sum over the ticks of the queue length
+	uint64_t max_queue;
+};
+
+/* The processes doing io. With no devices (the default) io is infinitely
+ * parallel: a process starts its io as soon as it asks and is done with
+ * it the ticks it asked for later. With devices, every process goes to
+ * the device dev[x], which serves one request at a time and queues the
+ * rest by its discipline.
+ *
+ * Nothing is done per tick: each io in progress is an event in a heap on
+ * the clock it ends, and complete() only pops those which end now. The
+ * clock is in the table, as io_end.
+ */
+class io_t
+{
+private:
+	struct event_t
+	{
+		uint64_t at; // clock the io ends
+		uint64_t seq; // the order the io was asked for, for equal clocks
+		pidx_t x;
+
+		bool operator>(const event_t& o) const
+		{
+			return at > o.at || (at == o.at && seq > o.seq);
+		}
+
+		void save(snapshot_writer& w) const
+		{
+			w.put(at);
+			w.put(seq);
+			w.put(x);
+		}
+
+		void load(snapshot_reader& r)
+		{
+			r.get(at);
+			r.get(seq);
+			r.get(x);
+		}
+	};
+
+	struct request_t
+	{
+		int64_t key; // 0 for fifo, the position for scan
+		uint64_t seq;
+		pidx_t x;
+		uint32_t dev;
+		int32_t dur; // ticks of io asked for
+
+		bool operator<(const request_t& o) const
+		{
+			return key < o.key || (key == o.key && seq < o.seq);
+		}
+
+		void save(snapshot_writer& w) const
+		{
+			w.put(key);
+			w.put(seq);
+			w.put(x);
+			w.put(dev);
+			w.put(dur);
+		}
+
+		void load(snapshot_reader& r)
+		{
+			r.get(key);
+			r.get(seq);
+			r.get(x);
+			r.get(dev);
+			r.get(dur);
+		}
+	};
+
+	struct device_t
+	{
+		int64_t head; // position of the last request served
+		uint8_t up; // direction of the scan
+		uint8_t busy;
+		uint64_t last_change; // clock of the last change to the queue length
+		io_device_stats_t stats;
+
+		void save(snapshot_writer& w) const
+		{
+			w.put(head);
+			w.put(up);
+			w.put(busy);
+			w.put(last_change);
+			w.put(stats);
+		}
+
+		void load(snapshot_reader& r)
+		{
+			r.get(head);
+			r.get(up);
+			r.get(busy);
+			r.get(last_change);
+			r.get(stats);
+		}
+	};
+
+	std::vector<event_t> events; // a heap, smallest at first
+	std::vector<device_t> devices;
+	std::vector<std::set<request_t> > queues; // of each device
+	io_discipline_t discipline;
+	uint64_t seq;
+	size_t count;
+
+	void start(proc_table_t& tbl, pidx_t x, uint32_t dev, int32_t dur, size_t Clock)
+	{
+		event_t e;
+		e.at = Clock + dur;
+		e.seq = seq++;
+		e.x = x;
+		events.push_back(e);
+		std::push_heap(events.begin(), events.end(), std::greater<event_t>());
+		tbl.io_end[x] = e.at;
+
+		if (!devices.empty())
+		{
+			devices[dev].busy = 1;
+			devices[dev].head = tbl.pos[x];
+			devices[dev].stats.busy += dur;
+		}
+	}
+
+	/* adds the ticks since the last change of the queue of d to its area */
+	void account(device_t& d, size_t qlen, size_t Clock)
+	{
+		d.stats.area += (uint64_t) qlen * (Clock - d.last_change);
+		d.last_change = Clock;
+	}
+
+	/* the next request of device dev by its discipline, which leaves the queue */
+	request_t next(uint32_t dev)
+	{
+		std::set<request_t>& q = queues[dev];
+		device_t& d = devices[dev];
+		auto iter = q.begin();
+
+		/* the nearest position on the way, else turn around. Of equal
+		 * positions, the oldest request
+		 */
+		if (discipline == IO_SCAN)
+		{
+			request_t at;
+			at.key = d.head;
+			at.seq = d.up? 0: UINT64_MAX;
+			iter = d.up? q.lower_bound(at): q.upper_bound(at);
+			if (d.up && iter == q.end())
+				d.up = 0;
+			else if (!d.up && iter == q.begin())
+				d.up = 1;
+
+			if (!d.up && iter != q.begin())
+			{
+				at.key = (--iter)->key;
+				at.seq = 0;
+				iter = q.lower_bound(at);
+			}
+			d.head = iter->key;
+		}
+
+		request_t r = *iter;
+		q.erase(iter);
+		return r;
+	}
+
+public:
+	io_t()
+	{
+		discipline = IO_FIFO;
+		seq = 0;
+		count = 0;
+	}
+
+	/* use ndev devices, 0 for infinitely parallel io */
+	void configure(size_t ndev, io_discipline_t discipline)
+	{
+		device_t d = device_t();
+		d.up = 1;
+		devices.assign(ndev, d);
+		queues.assign(ndev, std::set<request_t>());
+		this->discipline = discipline;
+	}
+
+	/* x asks for dur ticks of io at Clock */
+	void push(proc_table_t& tbl, pidx_t x, int32_t dur, size_t Clock)
+	{
+		count++;
+		uint32_t dev = devices.empty()? 0: (uint32_t) tbl.dev[x];
+		if (devices.empty() || !devices[dev].busy)
+		{
+			start(tbl, x, dev, dur, Clock);
+			return;
+		}
+
+		device_t& d = devices[dev];
+		account(d, queues[dev].size(), Clock);
+
+		request_t r;
+		r.key = discipline == IO_SCAN? tbl.pos[x]: 0;
+		r.seq = seq++;
+		r.x = x;
+		r.dev = dev;
+		r.dur = dur;
+		queues[dev].insert(r);
+		tbl.io_end[x] = IO_QUEUED;
+		d.stats.max_queue = std::max<uint64_t>(d.stats.max_queue, queues[dev].size());
+		d.stats.wait -= Clock; // the clock it starts is added back then
+	}
+
+	/* calls done(x) for every process whose io ends at Clock, in the order
+	 * they asked, and gives their devices the next requests
+	 */
+	template<typename F>
+	void complete(proc_table_t& tbl, size_t Clock, F done)
+	{
+		while (!events.empty() && events.front().at <= Clock)
+		{
+			std::pop_heap(events.begin(), events.end(), std::greater<event_t>());
+			pidx_t x = events.back().x;
+			events.pop_back();
+			count--;
+
+			if (!devices.empty())
+			{
+				uint32_t dev = (uint32_t) tbl.dev[x];
+				device_t& d = devices[dev];
+				d.busy = 0;
+				d.stats.requests++;
+				if (!queues[dev].empty())
+				{
+					account(d, queues[dev].size(), Clock);
+					request_t r = next(dev);
+					d.stats.wait += Clock;
+					start(tbl, r.x, dev, r.dur, Clock);
+				}
+			}
+
+			done(x);
+		}
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	/* statistics of every device, none without devices */
+	std::vector<io_device_stats_t> device_stats() const
+	{
+		std::vector<io_device_stats_t> all;
+		for (const device_t& d : devices)
+			all.push_back(d.stats);
+		return all;
+	}
+
+	void save(snapshot_writer& w) const
+	{
+		std::vector<request_t> queued;
+		for (const std::set<request_t>& q : queues)
+			queued.insert(queued.end(), q.begin(), q.end());
+
+		w.put(seq);
+		w.put((uint64_t) count);
+		w.put_each(events);
+		w.put_each(devices);
+		w.put_each(queued);
+	}
+
+	/* \retrun false if the state does not fit the devices configured */
+	bool load(snapshot_reader& r)
+	{
+		std::vector<device_t> saved;
+		std::vector<request_t> queued;
+		uint64_t n = 0;
+
+		r.get(seq);
+		r.get(n);
+		r.get_each(events);
+		r.get_each(saved);
+		r.get_each(queued);
+		count = n;
+
+		if (saved.size() != devices.size())
+			return false;
+		devices = saved;
+		for (const request_t& q : queued)
+		{
+			if (q.dev >= queues.size())
+				return false;
+			queues[q.dev].insert(q);
+		}
+		return true;
+	}
+};
+
+#endif
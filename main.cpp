@@ -1,167 +1,54 @@
 #include <algorithm>
 #include <climits>
-#include <fstream>
 #include <iostream>
-#include <stdlib.h>
 
 #include "cl_parser.h"
-#include "PCB.h"
+#include "options.h"
 #include "proc_queues.h"
+#include "simulator.h"
 
 /*************************************************
  ******************** TYPES **********************
  ************************************************/
 /* used by parse_input and contains the command-line options. */
-extern std::string help_output;		
-
-/* used by promote_priority */
-enum ops_t 
-{
-	IO,
-	AGE
-};
-
-/* enum to help identify which scheduler to user */
-enum scheduler_t 
-{
-	FIFO,
-	SJF,
-	PRIORITY,
-	EDF
-};
-
-/* user provided input values */
-struct env_t 
-{
-	int kernel_tq;
-	int user_tq;
-	int age_time;
-	int age_val;
-	bool interactive;
-	scheduler_t scheduler;
-	std::string file_name;
-	std::ofstream outfs;
-
-	void print()
-	{
-		std::cerr << "kernel_tq: " << kernel_tq << std::endl;
-		std::cerr << "user_tq: " << user_tq << std::endl;
-		std::cerr << "age_time: " << age_time << std::endl;
-		std::cerr << "age_value: " << age_val << std::endl;
-		std::cerr << "scheduler: " << scheduler << std::endl;
-		std::cerr << "file-name: " << file_name << std::endl;
-		std::cerr << std::endl; 
- 	}
-};
-
-/* object useful for computing average waiting and turnaround time */
-struct stats_t
-{
-	double awt, att;
-	size_t np;
-
-	void print()
-	{
-		printf("NP: %zu\n", np);
-		printf("AWT: %.3f\n", awt);
-		printf("ATT: %.3f\n", att);
-	}
-};
-
-/* Ready queue with a corresponding age queue. The age queue is
- * synchronized with the ready queue but is ordered by age time,
- * where older processes would be popped before younger ones.
- * Requires a little over twice the memory requirement compared
- * to just the age_q. The advantage is that ageing per iteration
- * is done in log(n) time instead of linear time. 
- */
-template<typename T>
-struct ready_age_t 
-{
-	T ready_q;
-	age_t<typename T::iterator> age_q;
-
-	void push(PCB& x)
-	{
-		ready_q.push(x);
-		age_q.push(ready_q.search(x));
-		assert(age_q.size() == ready_q.size());
-	}
-
-	void pop()
-	{
-		typename T::iterator iter;
-		iter = ready_q.search(ready_q.top());
-		age_q.erase(age_q.search(iter));
-		ready_q.pop();
-
-		assert(age_q.size() == ready_q.size());
-	}
-
-	PCB top()
-	{
-		return ready_q.top();
-	}
-
-	bool empty()
-	{
-		return ready_q.empty();
-	}
-
-	size_t size()
-	{
-		return ready_q.size();
-	}
-};
+extern const option_spec_t option_table[];
+extern const size_t option_count;
 
 /**************************************************
  ********************* MACROS *********************
  *************************************************/
 
-#define ISMAXED(x) (x==49 || x==99)
-#define CLOCK_LAST (size_t) INT_MIN
-#define ISKERNEL(x) (x>=50 && x<=99)
-#define DEFAULT_AGE_TIME 100
-#define DEFAULT_AGE_VALUE 10
-#define DEFAULT_KERNEL_QUANTUM 100
-#define DEFAULT_USER_QUANTUM 25
-#define DEFAULT_SCHEDULER PRIORITY
-
-#define GETS_CPU "Gets CPU"
-#define END "End"
-#define TQ_INTER "Clock Interrupt"
-#define IO_INTER "I/O Interrupt"
-#define AGED "Has Aged"
-#define ABORT "Cannot Meet Deadline"
-
-#define PRINT_STATE(os, Clock, x, state) (os << Clock << "\t" << (x).pid << "\t" << state << std::endl)
-#define PRINT_STATE_INTER(os, Clock, x, state) (os << "process " << (x).pid << " \'" << state << "\'" << std::endl)
-#define INTERACTIVE_WAIT(inp, line) while (std::getline(inp, line) && !line.empty())
+#define STRINGIFY(x) #x
+#define TO_STR(x) STRINGIFY(x)
+#define HELP_HEADER \
+	"Usage: ./main [OPTION(s)]\n\n" \
+	"Help:\n" \
+	"  -h, --help                            display this menu\n\n"
+#define HELP_FOOTER \
+	"\n" \
+	"Author: Sanfer D\'souza\n" \
+	"e-mail: dsouz039@umn.edu"
 
 /**************************************************
  ************* FUNCTOIN PROTOTYPES **************
  **************************************************/
 
-void parse_input(int, char**, env_t&);
+void parse_input(int, char**, sim_config_t&);
 
-template<typename T>
-void update(new_t&, ready_age_t<T>&, size_t Clock);
+bool parse_scheduler(std::string, scheduler_t&);
 
-template<typename T>
-void do_io(ready_age_t<T>&, io_t&, env_t&, size_t);
+bool parse_number(const std::string&, long, long, long&);
 
-template<typename T>
-void do_aging(ready_age_t<T>&, env_t&, size_t);
+bool parse_branch(const std::string&, branch_t&);
 
-template<typename T>
-void print_states(new_t&, ready_age_t<T>&, io_t&, PCB, bool, int, env_t&);
+bool parse_share(const std::string&, std::pair<std::string, uint32_t>&);
 
-template<typename T>
-void run_scheduler(new_t&, ready_age_t<T>&, env_t&, stats_t&);
+bool parse_quota(const std::string&, quota_spec_t&);
 
-inline void demote_priority(PCB&, env_t&);
+bool parse_level(const std::string&, cpu_level_t&);
 
-inline void promote_priority(PCB&, ops_t, env_t&);
+template<typename T, bool (*parse)(const std::string&, T&)>
+bool valid_item(const std::string&);
 
 
 /*****************************************************
@@ -170,685 +57,404 @@ inline void promote_priority(PCB&, ops_t, env_t&);
 int main(int argc, char *argv[])
 {
 	/* get the user-defined values */
-	env_t env;
-	stats_t stats;
-	parse_input(argc, argv, env);
+	sim_config_t config;
+	Simulator sim;
+	parse_input(argc, argv, config);
 
-	/* read the input file and create the new queue */
-	new_t new_q = create_new_queue(env.file_name);
-	stats.np = new_q.size();
-	stats.awt = 0.0; stats.att=0.0;
-
-	/* run the appropriate scheduler */
-	if (env.scheduler == FIFO)
-	{
-		ready_age_t<fifo_t> ready_age_q;
-		run_scheduler(new_q, ready_age_q, env, stats);		
-	}
-	else if (env.scheduler == PRIORITY)
-	{
-		ready_age_t<priority_t> ready_age_q;
-		run_scheduler(new_q, ready_age_q, env, stats);	
-	}
-	else if (env.scheduler == SJF)
+	/* read the input file into the simulator */
+	sim.configure(config);
+	if (!sim.load(config.file_name))
 	{
-		ready_age_t<sjf_t> ready_age_q;
-		run_scheduler(new_q, ready_age_q, env, stats);	
+		std::cerr << sim.error() << std::endl;
+		exit(EXIT_FAILURE);
 	}
-	else if (env.scheduler == EDF)
+
+	/* run the appropriate scheduler */
+	if (!sim.run())
 	{
-		ready_age_t<edf_t> ready_age_q;
-		run_scheduler(new_q, ready_age_q, env, stats);
+		/* print the stats of each branch */
+		for (size_t i=0; i!=sim.branch_stats().size(); i++)
+		{
+			const branch_t& b = config.branches[i];
+			std::cout << "******* BRANCH " << i+1 << ": " << scheduler_name[b.scheduler];
+			std::cout << " u" << b.user_tq << " k" << b.kernel_tq;
+			std::cout << " from clock " << sim.clock() << " *******" << std::endl;
+			sim.branch_stats()[i].print();
+			std::cout << std::endl;
+		}
+		return 0;
 	}
 	
 	/* print the stats */
-	stats.att /= (double) stats.np;
-	stats.awt /= (double) stats.np; 
 	std::cout << "************* STATS *************" << std::endl;
-	stats.print();
+	sim.stats().print();
 
 	/* all done folks */
-	env.outfs.close();
 	return 0;
 }
 
 
-/*************************************************************************/
-/*! This functions runs the scheduler given by the user
-    \param new_q is the queue of processes organized by arrival time
-    \param ready_age_q is the queue of processes organized by scheduler
-    			 with a corresponding age_q
-    \param env is the struct of user-provided values
+/***********************************************************************/
+/*! This functions converts a scheduler name to a scheduler_t.
+		\param name is the name of the scheduler, in any case
+		\param scheduler is written to if the name is valid
+		\retrun false if the name is not a scheduler
 */
-/*************************************************************************/    
-template<typename T>
-void run_scheduler(new_t& new_q, ready_age_t<T>& ready_age_q, env_t &env, stats_t &stats)
+/***********************************************************************/
+bool parse_scheduler(std::string name, scheduler_t& scheduler)
 {
-	io_t io_q;
-	bool running=false; // is there a process running?
-	PCB x;
-	int tq, org_tq;
-	std::string line;
-	std::vector<size_t> wait; // used only by edf scheduler
-
-	/* The first line of the output file are the column titles */
-	env.outfs << "CLOCK\tPID\tACTION" << std::endl; 
-
-	/* check if any processes are left to run */
-	if (new_q.empty())
-	{
-		std::cerr << "No processes to run" << std::endl;
-		return;
-	}
-
-	/* if edf fill the vector with 0s */
-	if (env.scheduler == EDF)
-		for (size_t i=0; i!=new_q.size()+1; i++)
-			wait.push_back(0);
-
-	if (env.interactive)
-	{
-		std::cerr << std::endl << "**** INTERACTIVE MODE ****" << std::endl;
-		std::cerr << "To enter next clock cycle, press <enter>" << std::endl;
-		INTERACTIVE_WAIT(std::cin, line);
-	}
-
-	/* each iteration is a clock tick */
-	for (size_t Clock=0; running || !(ready_age_q.empty() && io_q.empty() && new_q.empty()); Clock++)
-	{
-#ifdef _DEBUG
-		/* let us know which iteration is running */
-		if (!env.interactive && Clock % 100 == 0)
-			std::cerr << "*** Now at clock " << Clock << " ***" << std::endl;
-#endif
-
-		if (env.interactive)
-		{
-			std::cerr << "*** Now at clock " << Clock << " u" << env.user_tq;
-			std::cerr << " k" << env.kernel_tq << " a" << env.age_time << " ***";
-			std::cerr << std::endl;
-		}
-
-		/* do io to all processes in the io_q */
-		do_io(ready_age_q, io_q, env, Clock);
-
-		/* do aging */
-		if (env.scheduler == PRIORITY)
-			do_aging(ready_age_q, env, Clock);
-
-		/* update the ready queue with any new arrivals */
-		if (!new_q.empty())
-			update(new_q, ready_age_q, Clock);
-
-		/* if a process is running */
-		if (running)
-		{
-			x.bst--;
-			tq++;
-
-			/* process finished running */
-			if (x.bst == 0)
-			{
-				/* print to file termination action */
-				PRINT_STATE(env.outfs, Clock, x, END);
-				if (env.interactive)
-					PRINT_STATE_INTER(std::cout, Clock, x, END);
-				running = false;
-
-				/* update stats */
-				stats.att += (double)Clock;
-			}
-
-			/* clock-interrupted */
-			else if (tq == org_tq)
-			{
-				/* print to file clock-interrupt action */
-				PRINT_STATE(env.outfs, Clock, x, TQ_INTER);
-				if (env.interactive)
-					PRINT_STATE_INTER(std::cout, Clock, x, TQ_INTER);
-
-				demote_priority(x, env);
-				x.Clock = Clock; // update the time the process is pushed
-				ready_age_q.push(x);
-				running = false;				
-			}
-
-			/* io event occurs to an io process */
-			else if (env.scheduler != EDF && x.io != 0 && tq == org_tq-1)
-			{
-				/* print to file io-interrupt action */
-				PRINT_STATE(env.outfs, Clock, x, IO_INTER);
-				if (env.interactive)
-					PRINT_STATE_INTER(std::cout, Clock, x, IO_INTER);
-
-				x.io_counter = 0;
-				io_q.push_back(x);				
-				running = false;
-			}	
-		}
-
-		/* if a process is not running, start one that's available */
-		if (!running && !ready_age_q.empty())
-		{
-			/****************** GET NEXT PROCESS ****************/
-			if (env.scheduler == EDF) /* edf scheduler */
-			{
-				/* find process which can meet its deadline */
-				for (x=ready_age_q.top(); 
-						 Clock+x.bst>x.dline;
-						 x=ready_age_q.top())
-				{
-					wait[x.pid] = 0;
-					if (env.interactive)
-						PRINT_STATE_INTER(std::cout, Clock, x, ABORT);
-					ready_age_q.pop();
-					stats.np--;
-					if (ready_age_q.empty())
-						break;
-				}
-
-				/* we found a process to run. Remove it from the ready queue. */
-				if (!ready_age_q.empty())
-					ready_age_q.pop();
-			} 
-			else /* non-real time scheduler */
-			{
-				x = ready_age_q.top(); 
-				ready_age_q.pop();
-			}
-
-			/***************** SET UP RUNTIME *******************/
-			org_tq = ISKERNEL(x.pri)? env.kernel_tq: env.user_tq;
-			tq = 0;
-			running = true;				
-			
-			PRINT_STATE(env.outfs, Clock, x, GETS_CPU);		
-			if (env.interactive)
-				PRINT_STATE_INTER(std::cout, Clock, x, GETS_CPU);		
-		}
-
-		/* print if in interactive mode */
-		if (env.interactive)
-		{
-			print_states(new_q, ready_age_q, io_q, x, running, org_tq-tq, env);
-			INTERACTIVE_WAIT(std::cin, line);			
-		}
-
-		/* update wait time */
-		if (env.scheduler == EDF)
-		{ // need vector of values because we drop those that are aborted.
-			for (auto iter=ready_age_q.ready_q.begin(); iter!=ready_age_q.ready_q.end(); iter++)
-				wait[iter->pid]++;
-		}
-		else
-			stats.awt += (double) ready_age_q.size();
-	}
-
-	/* if edf, add all the wait times */
-	if (env.scheduler == EDF)
-		for (size_t n : wait)
-			if (n != 0)
-				stats.np++;
+	std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+	if (name.compare("FIFO") == 0)
+		scheduler = FIFO;
+	else if (name.compare("SJF") == 0)
+		scheduler = SJF;
+	else if (name.compare("PRIORITY") == 0)
+		scheduler = PRIORITY;
+	else if (name.compare("EDF") == 0)
+		scheduler = EDF;
+	else
+		return false;
+	return true;
 }
 
 
-/************************************************************************/
-/*! This functions performs one iteration of io. If a process finishes
-		its io it is moved to the ready_age_q.
-    \param ready_age_q is the queue of processes organized by scheduler
-    							 		 with a synchronized age queue
-    \param io_q is the list of processes currently doing io
-    \param env is the struct containing user-defined values
+/***********************************************************************/
+/*! This functions converts a whole number in a range.
+		\param text is the number
+		\param min is the least it may be
+		\param max is the most it may be
+		\param value is written to if the number is valid
+		\retrun false if text is not a number from min to max
 */
-/************************************************************************/ 
-template<typename T>
-void do_io(ready_age_t<T>& ready_age_q, io_t& io_q, env_t& env, size_t Clock)
+/***********************************************************************/
+bool parse_number(const std::string& text, long min, long max, long& value)
 {
-	io_t::iterator iter;
-	
-	/* iterate through each element */
-	for (iter=io_q.begin(); iter!=io_q.end();)
-	{
-		/* update the io counter and check if io is completed */		
-		iter->io_counter++;
-		if (iter->io_counter == iter->io) // io has completed
-		{
-			/* update priority */
-			promote_priority(*iter, IO, env);
-			
-			/* add to ready queue and remove from io queue */
-			if (ISMAXED(iter->pri))
-				iter->Clock = CLOCK_LAST;
-			else
-				iter->Clock = Clock; // update the clock when the process is pushed
-			ready_age_q.push(*iter);
-			
-			auto iter_next(++iter);
-			io_q.erase(--iter);
-
-			/* check if we removed the last element of the io queue */
-			if (io_q.empty()) // otherwise iter!=io_q.end() calls error
-				break;
-
-			iter = iter_next;
-		}
-		else
-			iter++;
-	}
+	char *end = NULL;
+	long v = std::strtol(text.c_str(), &end, 10);
+	if (text.empty() || *end != '\0' || v < min || v > max)
+		return false;
+	value = v;
+	return true;
 }
 
 
-/************************************************************************/
-/*! This functions ages each process in the ready queue. If the process
-		has aged, its priority is promoted.
-    \param ready_age_q is the queue of processes organized by scheduler
-    \param env is the struct containing user-defined values
-    \param Clock is the current time of execution
+/***********************************************************************/
+/*! This functions converts a what-if branch,
+		<scheduler>[:<user-quantum>[:<kernel-quantum>]]. A quantum left out,
+		empty or 0 is 0, for the one of the command line.
+		\param spec is the branch, an item of --branches
+		\param b is written to if the branch is valid
+		\retrun false if spec is not a branch
 */
-/************************************************************************/ 
-template<typename T>
-void do_aging(ready_age_t<T>& ready_age_q, env_t& env, size_t Clock)
+/***********************************************************************/
+bool parse_branch(const std::string& spec, branch_t& b)
 {
-	/* for each element in the ready queue */
-	for (auto iter_age = ready_age_q.age_q.begin();
-		 	iter_age != ready_age_q.age_q.end();
-		 	iter_age = ready_age_q.age_q.begin())
-	{
-		int pri = (*iter_age)->pri;
-		if (pri==49 || pri==99)
-			break;
-		else if (Clock-(*iter_age)->Clock == env.age_time)
-		{
-			auto iter_ready = ready_age_q.ready_q.search(*(*iter_age));
-
-			if (env.interactive && env.scheduler==PRIORITY)
-				PRINT_STATE_INTER(std::cout, Clock, *iter_ready, AGED);
-
-			PCB x = *iter_ready;
-			ready_age_q.ready_q.erase(iter_ready);
-			ready_age_q.age_q.pop();
-
-			promote_priority(x, AGE, env);
-			if (ISMAXED(x.pri))
-				x.Clock = CLOCK_LAST;
-			else
-				x.Clock = Clock;
-
-			ready_age_q.push(x);
-		}
-		else
-			break;
-	}
+	size_t colon = spec.find(':');
+	size_t colon2 = colon == std::string::npos? colon: spec.find(':', colon+1);
+	std::string user = colon == std::string::npos? "": spec.substr(colon+1, colon2-colon-1);
+	std::string kernel = colon2 == std::string::npos? "": spec.substr(colon2+1);
+	long user_tq = 0, kernel_tq = 0;
+
+	if (!parse_scheduler(spec.substr(0, colon), b.scheduler) ||
+			(!user.empty() && !parse_number(user, 0, INT32_MAX, user_tq)) ||
+			(!kernel.empty() && !parse_number(kernel, 0, INT32_MAX, kernel_tq)))
+		return false;
+	b.user_tq = (int) user_tq;
+	b.kernel_tq = (int) kernel_tq;
+	return true;
 }
 
 
-/************************************************************************/
-/*! This functions demotes the priority of clock-interrupted process.
-		The priority is decremented by the time-quantum corresponding to the
-		type of process (user or kernel). Arithmetic is restricted to [0,49]
-		for user processes and to [50,99] for kernel processes.
-    \param x is the current process to be demoted
+/***********************************************************************/
+/*! This functions converts the shares of a group, <group>:<shares>.
+		\param spec is the shares, an item of --group_shares
+		\param share is written to if the shares are valid
+		\retrun false if spec is not the shares of a group
 */
-/************************************************************************/    
-void demote_priority(PCB &x, env_t& env)
+/***********************************************************************/
+bool parse_share(const std::string& spec, std::pair<std::string, uint32_t>& share)
 {
-	int& pri = x.pri;
-	if (ISKERNEL(pri)) // kernel process
-	{ 
-		pri -= env.kernel_tq;
-		if (pri < 50)
-			pri = 50;
-	}
-	else // user process
-	{
-		pri -= env.user_tq;
-		if (pri < 0)
-			pri = 0;
-	}
+	size_t colon = spec.rfind(':');
+	long shares = 0;
+
+	if (colon == std::string::npos || !parse_number(spec.substr(colon+1), 1, (long) GROUP_STRIDE, shares))
+		return false;
+	share = std::make_pair(spec.substr(0, colon), (uint32_t) shares);
+	return true;
 }
 
 
-/************************************************************************/
-/*! This functions promotes the priority of IO/aging process.
-		If IO, the priority is incremented corresponding to the io-number.
-		If AGE, the priority is incremented corresponding to age_value. 
-		type of process (user or kernel). Arithmetic is restricted to [0,49]
-		for user processes and to [50,99] for kernel processes.
-    \param x is the current process to be demoted
-    \param op is type of operation {IO, AGE}
-    \param env is the struct of user-defined input values
+/***********************************************************************/
+/*! This functions converts a cpu quota, <class-or-group>:<quota>/<period>.
+		\param spec is the quota, an item of --cpu_quota
+		\param q is written to if the quota is valid
+		\retrun false if spec is not a quota
 */
-/************************************************************************/ 
-void promote_priority(PCB &x, ops_t op, env_t& env)
+/***********************************************************************/
+bool parse_quota(const std::string& spec, quota_spec_t& q)
 {
-	int old_pri = x.pri;
-	int& pri = x.pri += op==IO? x.io: env.age_val;
-
-	if (ISKERNEL(old_pri)) // kernel process
-	{
-		if (pri >= 99)
-			pri = 99;
-	}
-	else if (pri >= 49) // user process
-		pri = 49;
+	size_t colon = spec.rfind(':');
+	size_t slash = spec.rfind('/');
+	long quota = 0, period = 0;
+
+	if (colon == std::string::npos || slash == std::string::npos || slash < colon ||
+			!parse_number(spec.substr(colon+1, slash-colon-1), 1, INT32_MAX, quota) ||
+			!parse_number(spec.substr(slash+1), quota, INT32_MAX, period))
+		return false;
+	q.name = spec.substr(0, colon);
+	q.quota = (uint32_t) quota;
+	q.period = (uint32_t) period;
+	return true;
 }
 
 
 /***********************************************************************/
-/*! This functions transfers arriving processes from new_q to ready_age_q
-    \param new_q is the queue of processes organized by arrival time
-    \param ready_age_q is the queue of processes organized by scheduler
-    \param Clock is the current clock-tick
+/*! This functions converts a frequency of the cpu,
+		<mhz>:<busy-mW>:<idle-mW>.
+		\param spec is the frequency, an item of --cpu_levels
+		\param l is written to if the frequency is valid
+		\retrun false if spec is not a frequency
 */
-/***********************************************************************/    
-template<typename T>
-void update(new_t& new_q, ready_age_t<T>& ready_age_q, size_t Clock)
+/***********************************************************************/
+bool parse_level(const std::string& spec, cpu_level_t& l)
 {
-	/* following assertion is assumed */
-	assert(!new_q.empty()); // new_q is not empty
+	size_t colon = spec.find(':');
+	size_t colon2 = colon == std::string::npos? colon: spec.find(':', colon+1);
+	long mhz = 0, busy_mw = 0, idle_mw = 0;
+
+	if (colon2 == std::string::npos || !parse_number(spec.substr(0, colon), 1, 1000000, mhz) ||
+			!parse_number(spec.substr(colon+1, colon2-colon-1), 0, INT32_MAX, busy_mw) ||
+			!parse_number(spec.substr(colon2+1), 0, INT32_MAX, idle_mw))
+		return false;
+	l.mhz = (uint32_t) mhz;
+	l.busy_mw = (uint32_t) busy_mw;
+	l.idle_mw = (uint32_t) idle_mw;
+	return true;
+}
 
-	/* for each of the earliest elements in new_q, check if it has arrived yet */
-	for (PCB x = new_q.top(); x.arr == Clock; x = new_q.top())
-	{
-		if (ISMAXED(x.pri))
-			x.Clock = CLOCK_LAST;
-		else
-			x.Clock = Clock; // the time the process arrived
-		ready_age_q.push(x);
-		new_q.pop();
-		if (new_q.empty())
-			break;
-	}
+
+/* the check of option_table for the items of a list, read by parse */
+template<typename T, bool (*parse)(const std::string&, T&)>
+bool valid_item(const std::string& item)
+{
+	T value;
+	return parse(item, value);
 }
 
 
 /***********************************************************************/
-/*! This functions parses the user-provided input and stored in an env_t.
-		For any missing values or invalid ones, default values are used.
+/*! This functions parses the user-provided input and stored in a
+		sim_config_t.
+		Every option must be in option_table and its value of its kind, or
+		the program stops; missing values take their default. With
+		--config, the options of its --scenario are read from the file,
+		those of the command line winning.
 		\param argc is the first argument of main()
 		\param argv is the second argument of main()
-		\param env is the env_t obj which is written to by the function.
+		\param config is the sim_config_t obj which is written to by the function.
 */
 /***********************************************************************/
-void parse_input(int argc, char**argv, env_t& env)
+void parse_input(int argc, char**argv, sim_config_t& config)
 {
 	CLParser parser(argc, argv);
+	option_registry options(option_table, option_count);
 
 	/* display the help command */
 	if (parser.optionExists("-h") || parser.optionExists("--help"))
 	{
-		std::cout << help_output << std::endl;
+		std::cout << HELP_HEADER << options.help() << HELP_FOOTER << std::endl;
 		exit(0);
 	}
 
+	/* check every option, then add those of the scenario */
+	std::string error = options.check(parser);
+	if (error.empty() && parser.optionExists("--config"))
+		error = options.load(parser, parser.optionValue("--config"), options.text(parser, "--scenario"));
+	else if (error.empty() && parser.optionExists("--scenario"))
+		error = "The option \'--scenario\' needs --config.";
+	if (!error.empty())
+	{
+		std::cerr << error << std::endl;
+		std::exit(1);
+	}
+
 	/* get the file name */
 	if (parser.optionExists("--generate_processes"))
 	{
-		int how_many = std::atoi(parser.optionValue("--generate_processes").c_str());
-		if (how_many <= 0)
-			how_many = 10;
-
-		generate_test_cases(how_many, true);
-		env.file_name = "test_cases";
+		generate_test_cases((int) options.number(parser, "--generate_processes"), true);
+		config.file_name = "test_cases";
 	}
 	else if (parser.optionExists("--file_name"))
-		env.file_name = parser.optionValue("--file_name");
+		config.file_name = parser.optionValue("--file_name");
 	else
 	{
 		std::cerr << "No process file name provided" << std::endl;		
 		exit(EXIT_FAILURE);
 	}	
 
-	/* get time quantum for kernel level processes  */
-	if (parser.optionExists("--kernel_quantum"))
-		env.kernel_tq = std::atoi(parser.optionValue("--kernel_quantum").c_str());
-	else
-		env.kernel_tq = DEFAULT_KERNEL_QUANTUM;
-	if (env.kernel_tq <= 0)
-		env.kernel_tq = DEFAULT_KERNEL_QUANTUM;
+	/* get the time quanta, the age timer and the amount to age a process
+	 * when its age time expires
+	 */
+	config.kernel_tq = (int) options.number(parser, "--kernel_quantum");
+	config.user_tq = (int) options.number(parser, "--user_quantum");
+	config.age_time = (int) options.number(parser, "--age_timer");
+	config.age_val = (int) options.number(parser, "--age_amount");
+	config.lazy_aging = parser.optionExists("--lazy_aging");
 
-	/* get time quantum for user level processes */
-	if (parser.optionExists("--user_quantum"))
-		env.user_tq = std::atoi(parser.optionValue("--user_quantum").c_str());
-	else
-		env.user_tq = DEFAULT_USER_QUANTUM;
-	if (env.user_tq <= 0)
-		env.user_tq = DEFAULT_USER_QUANTUM;
-
-	/* get the age timer */
-	if (parser.optionExists("--age_timer"))
-		env.age_time = std::atoi(parser.optionValue("--age_timer").c_str());
-	else
-		env.age_time = DEFAULT_AGE_TIME;
+	/* get the io devices and the order they serve their queues in */
+	config.io_devices = (size_t) options.number(parser, "--io_devices");
+	config.io_discipline = options.choice(parser, "--io_discipline") == "scan"? IO_SCAN: IO_FIFO;
 
-	/* get the amount to age a process when its age time expires */
-	if (parser.optionExists("--age_amount"))
-		env.age_val = std::atoi(parser.optionValue("--age_amount").c_str());
-	else
-		env.age_val = DEFAULT_AGE_VALUE;
+	/* get the cost of a context switch, and of resuming with a cold cache */
+	config.switch_cost = (int) options.number(parser, "--switch_cost");
+	config.cache_penalty = (int) options.number(parser, "--cache_penalty");
 
 	/* get the scheduler type */
-	if (parser.optionExists("--scheduler"))
+	parse_scheduler(options.choice(parser, "--scheduler"), config.scheduler);
+
+	/* get the what-if branches, each with the quanta of the command line
+	 * unless it gives its own
+	 */
+	config.fork_at = NO_FORK;
+	if (parser.optionExists("--branches"))
 	{
-		std::string scheduler = parser.optionValue("--scheduler");
-		std::transform(scheduler.begin(), scheduler.end(), scheduler.begin(), ::toupper);
-		if (scheduler.compare("FIFO") == 0)
-			env.scheduler = FIFO;
-		else if (scheduler.compare("SJF") == 0)
-			env.scheduler = SJF;
-		else if (scheduler.compare("PRIORITY") == 0)
-			env.scheduler = PRIORITY;
-		else if (scheduler.compare("EDF") == 0)
-			env.scheduler = EDF;
-		else
+		for (const std::string& spec : options.items(parser, "--branches"))
 		{
-			std::cerr << "The scheduler \'" << scheduler << "\' is invalid." << std::endl;
-			std::exit(1);
+			branch_t b;
+			parse_branch(spec, b);
+			b.user_tq = b.user_tq? b.user_tq: config.user_tq;
+			b.kernel_tq = b.kernel_tq? b.kernel_tq: config.kernel_tq;
+			config.branches.push_back(b);
 		}
-	}
-	else
-		env.scheduler = DEFAULT_SCHEDULER;
-
-	/* check if interactive */
-	env.interactive = parser.optionExists("--interactive");
-
-	/* open the output file */
-	std::string output_fn = std::string("output-") + env.file_name;
-	std::replace(output_fn.begin(), output_fn.end(), '/', '-');
-	std::replace(output_fn.begin(), output_fn.end(), '\\', '-');
-	env.outfs.open(output_fn.c_str());
 
-#ifdef _DEBUG
-	env.print();
-#endif
-}
-
-std::string help_output = 
-"Usage: ./main [OPTION(s)]\n\n"
-"Help:\n"
-"  -h, --help\t\t\t\tdisplay this menu\n\n"
-"Mandatory arguments: only need one (ordered by precedence)\n"
-"  --generate_processes=<how-many>\tautomatically generates test cases\n"
-"  --file_name=<file-name>\t\tname of file with processes\n\n"
-"Optional arguments:\n"
-"  --age_amount=<age-amount>\t\tamount to increase priority after aging\n"
-"  --age_timer=<age-timer>\t\ttime to age\n"
-"  --interactive\t\t\t\topen interactive shell\n"
-"  --kernel_quantum=<kernel-quantum>\ttime quantum for kernel processes\n"
-"  --scheduler=<{fifo,sjf,priority,edf}> the process scheduler algorithm to use\n"
-"  --user_quantum=<user-quantum>\t\ttime quantum for user processes\n\n"
-"Author: Sanfer D\'souza\n"
-"e-mail: dsouz039@umn.edu";
-
-
-/***********************************************************************/
-/*! This functions prints the output during interactive running.
-		\param new_q is the new queue
-		\param ready_age_q is the ready_q following a scheduler protocol
-											 synchronized with a age_q.
-		\param io_q is the queue of all I/O processes (wait queue)
-		\param x is the running process if running=true and nonesense otherwise
-		\param running is a flag to identify if x is running or meaningless
-*/
-/***********************************************************************/
-template<typename T>
-void print_states(new_t& new_q, ready_age_t<T>& ready_age_q, io_t& io_q, PCB x, bool running, int tq, env_t& env)
-{
-
-	/***********************************************************************
-	 ********************************* TYPES *******************************
-	 ***********************************************************************/
+		/* get the clock at which to fork */
+		config.fork_at = (size_t) options.number(parser, "--fork_at");
+	}
 
-	enum state_t 
+	/* get the shares of the groups */
+	for (const std::string& spec : options.items(parser, "--group_shares"))
 	{
-		NEW,
-		READY,
-		IO,
-		RUNNING
-	};
+		std::pair<std::string, uint32_t> share;
+		parse_share(spec, share);
+		config.group_shares.push_back(share);
+	}
 
-	struct pair_t 
+	/* get the cpu quotas */
+	for (const std::string& spec : options.items(parser, "--cpu_quota"))
 	{
-		PCB x;
-		state_t state;
-	};
+		quota_spec_t q;
+		parse_quota(spec, q);
+		config.cpu_quotas.push_back(q);
+	}
 
-	class mycmp_pid 
-	{
-	public:
-		int operator() (const pair_t& lhs, const pair_t& rhs) const
-		{
-			return rhs.x.pid - lhs.x.pid;
-		}
-	};
+	/* get the governor of the cpu frequency and how often ondemand looks */
+	config.governor = GOV_NONE;
+	for (int i=GOV_PERFORMANCE; i!=GOVERNORS; i++)
+		if (options.choice(parser, "--governor") == governor_name[i])
+			config.governor = (governor_t) i;
+	config.governor_sample = (int) options.number(parser, "--governor_sample");
 
-	struct functor 
+	/* get the frequencies of the cpu, in order */
+	if (config.governor != GOV_NONE)
 	{
-		static std::string converter(state_t a)
+		for (const std::string& spec : options.items(parser, "--cpu_levels"))
 		{
-			switch (a)
+			cpu_level_t l;
+			parse_level(spec, l);
+			config.cpu_levels.push_back(l);
+		}
+		std::sort(config.cpu_levels.begin(), config.cpu_levels.end(), 
+							[](const cpu_level_t& lhs, const cpu_level_t& rhs) { return lhs.mhz < rhs.mhz; });
+		for (size_t i=1; i<config.cpu_levels.size(); i++)
+			if (config.cpu_levels[i].mhz == config.cpu_levels[i-1].mhz)
 			{
-				case NEW:
-					return "new";
-				case READY:
-					return "ready";
-				case IO:
-					return "io";
-				case RUNNING:
-					return "running";
+				std::cerr << "The cpu level of " << config.cpu_levels[i].mhz << " MHz is given twice." << std::endl;
+				std::exit(1);
 			}
-		}
-	};
-
-	typedef priority_queue<pair_t, mycmp_pid> pq_t;
-	pq_t io_vec, vec;
-
-	/***********************************************************************
-	 ****************************** CATEGORIZE *****************************
-	 ***********************************************************************/
-
-	if (running)
-		vec.push({.x=x, .state=RUNNING});
-
-	for (auto iter=new_q.begin(); iter!=new_q.end(); iter++)
-		vec.push({.x=*iter, .state=NEW});
-
-	for (auto iter=ready_age_q.ready_q.begin(); iter!=ready_age_q.ready_q.end(); iter++)
-		vec.push({.x=*iter, .state=READY});
-
-	for (auto iter=io_q.begin(); iter!=io_q.end(); iter++)
-		vec.push({.x=*iter, .state=IO});
-
-	static int size;
-	if (size==0)
-	 	size = new_q.size() + ready_age_q.ready_q.size() + 1 + (running==true);
-	
-	std::vector<bool> end;
-	for (int i=0; i!=size; end.push_back(true), ++i); end[0]=false;
-	for (auto iter=vec.begin(); iter!=vec.end(); end[iter++->x.pid]=false);
-
-	/***********************************************************************
-	 ********************************* PRINT *******************************
-	 ***********************************************************************/
-
-	std::cout << std::endl;
-
-	std::cout << "RUNNING:\t";
-	if (running)
-		std::cout << "pid: " << x.pid << " (tq: " << tq << ")";
-	else
-		std::cout << "none";
-	std::cout << std::endl;
-
-	std::cout << "TERMINATED:";
-	for (auto iter=end.begin(); iter!=end.end(); iter++)
-		if (*iter)
-			std::cout << "\t" << iter-end.begin();
-	std::cout << std::endl;
-
-	std::cout << "IO-QUEUE:";
-	for (auto iter=vec.begin(); iter!=vec.end(); iter++)
-		if (iter->state == IO)
-			std::cout << "\t" << iter->x.pid << "(" << iter->x.io-iter->x.io_counter << ")";
-	std::cout << std::endl;
-	std::cout << std::endl;
-
-	std::cout << "STATE:\t";
-	for (auto iter=vec.begin(); iter!=vec.end(); iter++)
-		std::cout << "\t" << functor::converter(iter->state);
-	std::cout << std::endl;
-
-	std::cout << "PID:\t";
-	for (auto iter=vec.begin(); iter!=vec.end(); iter++)
-		std::cout << "\t" << iter->x.pid << "(" << (ISKERNEL(iter->x.pri)? 'k': 'u') << ")";
-	std::cout << std::endl;
-
-	if (env.scheduler == PRIORITY)
-	{
-		std::cout << "PRIORITY:";
-		for (auto iter=vec.begin(); iter!=vec.end(); iter++)
-			std::cout << "\t" << iter->x.pri;
-		std::cout << std::endl;	
-	}
-
-	std::cout << "BURST:\t";
-	for (auto iter=vec.begin(); iter!=vec.end(); iter++)
-		std::cout << "\t" << iter->x.bst;
-	std::cout << std::endl;
-
-	std::cout << "ARRIVAL:";
-	for (auto iter=vec.begin(); iter!=vec.end(); iter++)
-		std::cout << "\t" << iter->x.arr;
-	std::cout << std::endl;
-
-	if (env.scheduler == PRIORITY)
-	{
-		std::cout << "Clock:\t";
-		for (auto iter=vec.begin(); iter!=vec.end(); iter++)
+		if (config.cpu_levels.empty())
 		{
-			if (iter->x.Clock == CLOCK_LAST)
-				std::cout << "\t" << (int) -1;
-			else
-				std::cout << "\t" << iter->x.Clock;
+			std::cerr << "No cpu levels given" << std::endl;
+			std::exit(1);
 		}
-		std::cout << std::endl;
 	}
 
-	if (env.scheduler != EDF)
+	/* check if interactive */
+	config.interactive = parser.optionExists("--interactive");
+
+	/* get how often to checkpoint, and whether to resume from the last one */
+	config.checkpoint_every = (size_t) options.number(parser, "--checkpoint");
+	config.resume = parser.optionExists("--resume");
+	config.packed = parser.optionExists("--packed_output");
+	config.indexed = parser.optionExists("--index_output");
+
+	/* the output file and checkpoint file names */
+	std::string base_fn = config.file_name;
+	std::replace(base_fn.begin(), base_fn.end(), '/', '-');
+	std::replace(base_fn.begin(), base_fn.end(), '\\', '-');
+	config.output_name = std::string("output-") + base_fn + (config.packed? PACKED_EXT: "");
+	config.checkpoint_name = std::string("checkpoint-") + base_fn;
+
+	/* get whether to write per-process metrics, and how */
+	config.metrics_csv = false;
+	if (parser.optionExists("--metrics_output"))
 	{
-		std::cout << "IO:\t";
-		for (auto iter=vec.begin(); iter!=vec.end(); iter++)
-			std::cout << "\t" << iter->x.io;
-		std::cout << std::endl;
+		config.metrics_name = std::string("metrics-") + base_fn;
+		config.metrics_csv = options.choice(parser, "--metrics_output") == "csv";
 	}
 
-	if (env.scheduler == EDF)
-	{
-		std::cout << "DLINE:\t";
-		for (auto iter=vec.begin(); iter!=vec.end(); iter++)
-			std::cout << "\t" << iter->x.dline;
-		std::cout << std::endl;
-	}
+#ifdef _DEBUG
+	config.print();
+#endif
+}
 
-	std::cout << std::endl;
-}
\ No newline at end of file
+/* every option of the command line and of config files, mandatory ones
+ * first in order of precedence, then by name
+ */
+const option_spec_t option_table[] = 
+{
+	{"--generate_processes", OPT_INT, "how-many", 1, INT32_MAX, NULL, true, "automatically generates test cases", NULL},
+	{"--file_name", OPT_TEXT, "file-name", 0, 0, NULL, true, "name of file with processes", NULL},
+	{"--age_amount", OPT_INT, "age-amount", 0, INT32_MAX, TO_STR(DEFAULT_AGE_VALUE), false, 
+	 "amount to increase priority after aging", NULL},
+	{"--age_timer", OPT_INT, "age-timer", 1, INT32_MAX, TO_STR(DEFAULT_AGE_TIME), false, "time to age", NULL},
+	{"--branches", OPT_LIST, "sched[:uq[:kq]],...", 0, 0, NULL, false, 
+	 "at --fork_at, continue with each of these\nschedulers and quanta in parallel", valid_item<branch_t, parse_branch>},
+	{"--cache_penalty", OPT_INT, "ticks", 0, INT32_MAX, "0", false, 
+	 "extra switch ticks when a process resumes\nafter another one ran", NULL},
+	{"--checkpoint", OPT_INT, "ticks", 0, LONG_MAX, NULL, false, "save a checkpoint every <ticks> clock ticks", NULL},
+	{"--config", OPT_TEXT, "file", 0, 0, NULL, false, 
+	 "read the options of --scenario, and those\nbefore the first scenario, from <file>", NULL},
+	{"--cpu_levels", OPT_LIST, "mhz:busy-mW:idle-mW,...", 0, 0, DEFAULT_CPU_LEVELS, false, 
+	 "frequencies of the cpu and their power,\nwith --governor", valid_item<cpu_level_t, parse_level>},
+	{"--cpu_quota", OPT_LIST, "name:quota/period,...", 0, 0, NULL, false, 
+	 "limit the kernel or user processes, or a\ngroup, to <quota> ticks every <period>", valid_item<quota_spec_t, parse_quota>},
+	{"--fork_at", OPT_INT, "clock", 0, LONG_MAX, "0", false, "clock at which the --branches start", NULL},
+	{"--governor", OPT_CHOICE, "performance,powersave,ondemand", 0, 0, NULL, false, 
+	 "scale the cpu frequency, bursts being in\nticks at the top one", NULL},
+	{"--governor_sample", OPT_INT, "ticks", 1, INT32_MAX, TO_STR(DEFAULT_GOVERNOR_SAMPLE), false, 
+	 "ticks between the looks of ondemand at\nthe load", NULL},
+	{"--group_shares", OPT_LIST, "group:shares,...", 0, 0, NULL, false, 
+	 "cpu shares of the groups of the process\nfile (default: 1024 each)", valid_item<std::pair<std::string, uint32_t>, parse_share>},
+	{"--index_output", OPT_FLAG, NULL, 0, 0, NULL, false, 
+	 "also write an index of the Gantt chart, to\nbe queried with gantt_query", NULL},
+	{"--interactive", OPT_FLAG, NULL, 0, 0, NULL, false, "open interactive shell", NULL},
+	{"--io_devices", OPT_INT, "devices", 0, MAX_IO_DEVICES, NULL, false, 
+	 "io devices, each serving one process at a\ntime (default: io is not limited)", NULL},
+	{"--io_discipline", OPT_CHOICE, "fifo,scan", 0, 0, "fifo", false, "order a device serves its queue in", NULL},
+	{"--kernel_quantum", OPT_INT, "kernel-quantum", 1, INT32_MAX, TO_STR(DEFAULT_KERNEL_QUANTUM), false, 
+	 "time quantum for kernel processes", NULL},
+	{"--lazy_aging", OPT_FLAG, NULL, 0, 0, NULL, false, 
+	 "age the priority scheduler on demand instead\nof every age_timer ticks (same schedule)", NULL},
+	{"--metrics_output", OPT_CHOICE, ",bin,csv", 0, 0, NULL, false, 
+	 "write per-process metrics to\nmetrics-<file-name>[.csv]", NULL},
+	{"--packed_output", OPT_FLAG, NULL, 0, 0, NULL, false, 
+	 "write the Gantt chart packed, to be read\nwith gantt_cat", NULL},
+	{"--resume", OPT_FLAG, NULL, 0, 0, NULL, false, "continue from the last checkpoint", NULL},
+	{"--scenario", OPT_TEXT, "name", 0, 0, NULL, false, "the scenario of the --config file to run", NULL},
+	{"--scheduler", OPT_CHOICE, "fifo,sjf,priority,edf", 0, 0, DEFAULT_SCHEDULER, false, 
+	 "the process scheduler algorithm to use", NULL},
+	{"--switch_cost", OPT_INT, "ticks", 0, INT32_MAX, "0", false, "ticks lost on every context switch", NULL},
+	{"--user_quantum", OPT_INT, "user-quantum", 1, INT32_MAX, TO_STR(DEFAULT_USER_QUANTUM), false, 
+	 "time quantum for user processes", NULL}
+};
+const size_t option_count = sizeof(option_table) / sizeof(option_table[0]);
@@ -0,0 +1,104 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "checkpoint.h"
+#include "PCB.h"
+
+#define METRICS_MAGIC 0x314352544d535350ULL // "PSSMTRC1"
+
+/* Per-process metrics, one row per process which terminated, in the
+ * order they terminated. Written with --metrics_output at the end of a
+ * run. The binary layout is columnar, like proc_table_t: METRICS_MAGIC,
+ * then each column as a count and its values, in the order below, so a
+ * column loads with a single read. Values are in the native layout, as
+ * in a checkpoint.
+ */
+struct proc_metrics_t
+{
+	std::vector<int32_t> pid;
+	std::vector<uint64_t> response; // first dispatch - arrival
+	std::vector<uint64_t> waiting; // turnaround - burst - time doing io
+	std::vector<uint64_t> turnaround; // termination - arrival
+	std::vector<uint32_t> switches; // times the process got the cpu
+	std::vector<int32_t> io_count; // times the process did io
+	std::vector<int64_t> slack; // deadline - termination, < 0 if missed
+
+	size_t size() const
+	{
+		return pid.size();
+	}
+
+	/* adds a row for x, which has just terminated */
+	void record(const proc_table_t& tbl, pidx_t x)
+	{
+		uint64_t tt = tbl.end[x] - tbl.arr[x];
+
+		pid.push_back(tbl.pid[x]);
+		response.push_back(tbl.start[x] - tbl.arr[x]);
+		waiting.push_back(tt - tbl.cpu_ticks[x] - tbl.switch_ticks[x] - tbl.io_total[x]);
+		turnaround.push_back(tt);
+		switches.push_back(tbl.dispatches[x]);
+		io_count.push_back(tbl.io_count[x]);
+		slack.push_back((int64_t) tbl.dline[x] - (int64_t) tbl.end[x]);
+	}
+
+	/* recomputes the rows of the processes which terminated before the
+	 * state in tbl was reached, for a resumed run or a branch. Only one
+	 * process ends per clock, so their order is that of tbl.end.
+	 */
+	void rebuild(const proc_table_t& tbl)
+	{
+		std::vector<pidx_t> ended;
+
+		*this = proc_metrics_t();
+		for (pidx_t x=0; x!=tbl.size(); x++)
+			if (tbl.end[x] != NOT_ENDED)
+				ended.push_back(x);
+		std::sort(ended.begin(), ended.end(),
+							[&tbl](pidx_t lhs, pidx_t rhs) { return tbl.end[lhs] < tbl.end[rhs]; });
+		for (pidx_t x : ended)
+			record(tbl, x);
+	}
+
+	/* \retrun false if the file could not be written */
+	bool save_binary(const std::string& name) const
+	{
+		snapshot_writer w;
+
+		if (!w.open(name))
+			return false;
+		w.put((uint64_t) METRICS_MAGIC);
+		w.put(pid);
+		w.put(response);
+		w.put(waiting);
+		w.put(turnaround);
+		w.put(switches);
+		w.put(io_count);
+		w.put(slack);
+		return w.commit();
+	}
+
+	/* \retrun false if the file could not be written */
+	bool save_csv(const std::string& name) const
+	{
+		FILE *fp = fopen(name.c_str(), "w");
+		if (!fp)
+			return false;
+
+		fprintf(fp, "pid,response,waiting,turnaround,switches,io_count,slack\n");
+		for (size_t i=0; i!=size(); i++)
+			fprintf(fp, "%d,%llu,%llu,%llu,%u,%d,%lld\n", pid[i],
+							(unsigned long long) response[i], (unsigned long long) waiting[i],
+							(unsigned long long) turnaround[i], switches[i], io_count[i],
+							(long long) slack[i]);
+		return fclose(fp) == 0;
+	}
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef OBSERVERS_H
+#define OBSERVERS_H
+
+#include <cstddef>
+
+#include "PCB.h"
+
+/* The observers of a run: everything done at an event of the scheduler
+ * other than scheduling, such as writing the Gantt chart. The scheduler
+ * takes its observer as a template parameter and calls it at each event,
+ * with the clock and the process, once the table is up to date. The
+ * calls are resolved when the library is compiled, so a run with
+ * null_observer_t is the scheduling alone; the handlers of
+ * Simulator::subscribe are called through one of them. An observer has
+ * every member of null_observer_t, most simply by deriving from it.
+ *
+ * The events, in the order they can happen to a process:
+ *   arrival     it entered the ready queue for the first time
+ *   aging       its priority was raised for waiting age_timer ticks
+ *   dispatch    it got the cpu
+ *   preempt     its quantum was over
+ *   throttle    its cpu quota was used up, see bandwidth_t
+ *   io_start    it left the cpu for io
+ *   io_end      its io was done and it is ready again
+ *   abort       it could not meet its deadline (edf)
+ *   completion  its burst was done
+ */
+struct null_observer_t
+{
+	/* aging is only looked for if an observer wants it at Clock, as a
+	 * lazily aged ready queue has to work it out (see lazy_ready_t)
+	 */
+	bool wants_aging(size_t) const
+	{
+		return false;
+	}
+
+	void arrival(size_t, pidx_t)
+	{
+	}
+
+	void aging(size_t, pidx_t)
+	{
+	}
+
+	void dispatch(size_t, pidx_t)
+	{
+	}
+
+	void preempt(size_t, pidx_t)
+	{
+	}
+
+	void throttle(size_t, pidx_t)
+	{
+	}
+
+	void io_start(size_t, pidx_t)
+	{
+	}
+
+	void io_end(size_t, pidx_t)
+	{
+	}
+
+	void abort(size_t, pidx_t)
+	{
+	}
+
+	void completion(size_t, pidx_t)
+	{
+	}
+};
+
+/* two observers as one, A called before B */
+template<typename A, typename B>
+struct observer_pair_t
+{
+	A first;
+	B second;
+
+	observer_pair_t(const A& first, const B& second)
+		: first(first), second(second)
+	{
+	}
+
+	bool wants_aging(size_t Clock) const
+	{
+		return first.wants_aging(Clock) || second.wants_aging(Clock);
+	}
+
+	void arrival(size_t Clock, pidx_t x)
+	{
+		first.arrival(Clock, x);
+		second.arrival(Clock, x);
+	}
+
+	void aging(size_t Clock, pidx_t x)
+	{
+		first.aging(Clock, x);
+		second.aging(Clock, x);
+	}
+
+	void dispatch(size_t Clock, pidx_t x)
+	{
+		first.dispatch(Clock, x);
+		second.dispatch(Clock, x);
+	}
+
+	void preempt(size_t Clock, pidx_t x)
+	{
+		first.preempt(Clock, x);
+		second.preempt(Clock, x);
+	}
+
+	void throttle(size_t Clock, pidx_t x)
+	{
+		first.throttle(Clock, x);
+		second.throttle(Clock, x);
+	}
+
+	void io_start(size_t Clock, pidx_t x)
+	{
+		first.io_start(Clock, x);
+		second.io_start(Clock, x);
+	}
+
+	void io_end(size_t Clock, pidx_t x)
+	{
+		first.io_end(Clock, x);
+		second.io_end(Clock, x);
+	}
+
+	void abort(size_t Clock, pidx_t x)
+	{
+		first.abort(Clock, x);
+		second.abort(Clock, x);
+	}
+
+	void completion(size_t Clock, pidx_t x)
+	{
+		first.completion(Clock, x);
+		second.completion(Clock, x);
+	}
+};
+
+#endif
@@ -0,0 +1,338 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cl_parser.h"
+
+#define HELP_COLUMN 40 // the help of each option starts here in --help
+#define HELP_WIDTH 80 // a default which would go past this goes on a line of its own
+#define CONFIG_COMMENT '#' // the rest of a line of a config file is a comment
+
+/* what the value of an option may be */
+enum option_kind_t
+{
+	OPT_FLAG, // none
+	OPT_INT, // a whole number from min to max
+	OPT_CHOICE, // one of arg, in any case, a list separated by ','. With a ',' first it may be left out.
+	OPT_TEXT, // anything
+	OPT_LIST // items separated by ',', each of them checked by item
+};
+
+/* \retrun false if item is not a valid item of an OPT_LIST option */
+typedef bool (*item_check_t)(const std::string& item);
+
+/* one option of the command line, and of config files */
+struct option_spec_t
+{
+	const char *name; // with the leading "--"
+	option_kind_t kind;
+	const char *arg; // what the value is, for --help; the choices of OPT_CHOICE
+	long min, max; // of OPT_INT
+	const char *def; // the value if the option is not given, NULL for none
+	bool mandatory; // one of the mandatory options must be given
+	const char *help; // for --help, lines separated by '\n'
+	item_check_t item; // of OPT_LIST, NULL for the other kinds
+};
+
+/* The options a program takes, from a table of option_spec_t. The
+ * options given are checked against it, so a misspelt option or a value
+ * of the wrong kind is an error rather than ignored, and --help is made
+ * from it. Values are looked up by name, with the default of the table
+ * if not given.
+ *
+ * A config file holds scenarios, each a set of options, one per line:
+ *
+ *   # comment
+ *   scheduler=fifo          options before the first scenario are in all
+ *   [short]                 the scenario short
+ *   user_quantum=5
+ *   lazy_aging
+ *
+ * The leading "--" of the names may be left out. The whole file is
+ * checked, not only the scenario run. The options of the command line
+ * win over those of the scenario, which win over those before the first.
+ */
+class option_registry
+{
+private:
+	const option_spec_t *table;
+	size_t n;
+	std::map<std::string, size_t> by_name;
+
+	static std::string trim(const std::string& s)
+	{
+		size_t first = s.find_first_not_of(" \t\r");
+		size_t last = s.find_last_not_of(" \t\r");
+		return first == std::string::npos? std::string(""): s.substr(first, last-first+1);
+	}
+
+	/* \retrun the edits to turn a into b */
+	static size_t distance(const std::string& a, const std::string& b)
+	{
+		std::vector<size_t> row(b.size()+1);
+		for (size_t j=0; j<=b.size(); j++)
+			row[j] = j;
+		for (size_t i=1; i<=a.size(); i++)
+		{
+			size_t diag = row[0];
+			row[0] = i;
+			for (size_t j=1; j<=b.size(); j++)
+			{
+				size_t up = row[j];
+				row[j] = std::min(std::min(row[j]+1, row[j-1]+1), diag + (a[i-1] != b[j-1]));
+				diag = up;
+			}
+		}
+		return row[b.size()];
+	}
+
+	/* \retrun the choices of an OPT_CHOICE option, "" first if it may be left out */
+	static std::vector<std::string> choices(const option_spec_t& o)
+	{
+		std::vector<std::string> all;
+		std::string list = std::string(o.arg) + ",";
+		for (size_t pos=list.find(','); pos!=std::string::npos; pos=list.find(','))
+		{
+			all.push_back(list.substr(0, pos));
+			list.erase(0, pos+1);
+		}
+		return all;
+	}
+
+	/* \retrun value in lower case, as choices are given in any case */
+	static std::string lower(std::string value)
+	{
+		std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+		return value;
+	}
+
+	/* \retrun the items of the list value, the empty ones left out */
+	static std::vector<std::string> split(const std::string& value)
+	{
+		std::vector<std::string> all;
+		std::string list = value + ",";
+		for (size_t pos=list.find(','); pos!=std::string::npos; pos=list.find(','))
+		{
+			if (pos != 0)
+				all.push_back(list.substr(0, pos));
+			list.erase(0, pos+1);
+		}
+		return all;
+	}
+
+	/* \retrun the line of o in --help */
+	static std::string usage(const option_spec_t& o)
+	{
+		std::string line = std::string("  ") + o.name;
+		if (o.kind == OPT_CHOICE && o.arg[0] == ',')
+			line += std::string("[=<{") + (o.arg+1) + "}>]";
+		else if (o.kind == OPT_CHOICE)
+			line += std::string("=<{") + o.arg + "}>";
+		else if (o.kind != OPT_FLAG)
+			line += std::string("=<") + o.arg + ">";
+		line += line.size() < HELP_COLUMN? std::string(HELP_COLUMN - line.size(), ' '): std::string(" ");
+
+		for (const char *c=o.help; *c; c++)
+			line += *c == '\n'? "\n" + std::string(HELP_COLUMN, ' '): std::string(1, *c);
+		if (o.def != NULL && o.kind != OPT_FLAG)
+		{
+			std::string def = std::string("(default: ") + o.def + ")";
+			bool fits = line.size() - (line.rfind('\n') + 1) + 1 + def.size() <= HELP_WIDTH;
+			line += (fits? std::string(" "): "\n" + std::string(HELP_COLUMN, ' ')) + def;
+		}
+		return line + "\n";
+	}
+
+public:
+	option_registry(const option_spec_t *table, size_t n)
+	{
+		this->table = table;
+		this->n = n;
+		for (size_t i=0; i!=n; i++)
+			by_name[table[i].name] = i;
+	}
+
+	/* \retrun the option name, NULL if there is none */
+	const option_spec_t *find(const std::string& name) const
+	{
+		auto iter = by_name.find(name);
+		return iter == by_name.end()? NULL: &table[iter->second];
+	}
+
+	/* \retrun why option name cannot have value, "" if it can */
+	std::string check(const std::string& name, const std::string& value) const
+	{
+		const option_spec_t *o = find(name);
+
+		if (o == NULL)
+		{
+			const option_spec_t *best = NULL;
+			size_t best_distance = 3; // more edits than that is not a typo
+			for (size_t i=0; i!=n; i++)
+				if (distance(name, table[i].name) < best_distance)
+				{
+					best = &table[i];
+					best_distance = distance(name, table[i].name);
+				}
+			return "The option \'" + name + "\' is unknown" + (best? std::string(", did you mean ") + best->name + "?": ".");
+		}
+
+		if (o->kind == OPT_FLAG && !value.empty())
+			return "The option \'" + name + "\' takes no value.";
+
+		if (o->kind == OPT_INT)
+		{
+			char *end = NULL;
+			long v = std::strtol(value.c_str(), &end, 10);
+			if (value.empty() || *end != '\0' || v < o->min || v > o->max)
+				return "The value \'" + value + "\' of " + name + " is invalid (from " +
+					std::to_string(o->min) + " to " + std::to_string(o->max) + ").";
+		}
+
+		if (o->kind == OPT_CHOICE)
+		{
+			std::vector<std::string> all = choices(*o);
+			if (std::find(all.begin(), all.end(), lower(value)) == all.end())
+			{
+				std::string list;
+				for (size_t i=0; i!=all.size(); i++)
+					if (!all[i].empty())
+						list += (list.empty()? "": i+1 == all.size()? " or ": ", ") + all[i];
+				return "The value \'" + value + "\' of " + name + " is invalid (" + list + ").";
+			}
+		}
+
+		if ((o->kind == OPT_TEXT || o->kind == OPT_LIST) && value.empty())
+			return "The option \'" + name + "\' needs a value.";
+
+		if (o->kind == OPT_LIST)
+			for (const std::string& item : split(value))
+				if (!o->item(item))
+					return "The item \'" + item + "\' of " + name + " is invalid (" + o->arg + ").";
+		return "";
+	}
+
+	/* \retrun why the options of parser are not valid, "" if they are */
+	std::string check(const CLParser& parser) const
+	{
+		for (auto& option : parser)
+		{
+			std::string error = check(option.first, option.second);
+			if (!error.empty())
+				return error;
+		}
+		return "";
+	}
+
+	/* adds the options of scenario in the config file name to parser,
+	 * those of the file before its first scenario if scenario is "".
+	 * \retrun why they could not be, "" if they were
+	 */
+	std::string load(CLParser& parser, const std::string& name, const std::string& scenario) const
+	{
+		std::ifstream is(name.c_str());
+		std::vector<std::pair<std::string, std::string> > common, chosen;
+		std::set<std::string> scenarios, in_section;
+		std::string line, section;
+		bool found = scenario.empty();
+
+		if (!is.is_open())
+			return "Could not read the config file \'" + name + "\'";
+
+		for (size_t line_no=1; std::getline(is, line); line_no++)
+		{
+			std::string where = name + ":" + std::to_string(line_no) + ": ";
+			line = trim(line.substr(0, line.find(CONFIG_COMMENT)));
+			if (line.empty())
+				continue;
+
+			/* a new scenario */
+			if (line[0] == '[')
+			{
+				section = trim(line.substr(1, line.size()-2));
+				if (line[line.size()-1] != ']' || section.empty())
+					return where + "The scenario \'" + line + "\' is invalid.";
+				if (!scenarios.insert(section).second)
+					return where + "The scenario \'" + section + "\' is given twice.";
+				in_section.clear();
+				found = found || section == scenario;
+				continue;
+			}
+
+			/* an option of the scenario */
+			size_t equal = line.find('=');
+			std::string option = trim(line.substr(0, equal));
+			std::string value = equal == std::string::npos? std::string(""): trim(line.substr(equal+1));
+			if (option.compare(0, 2, "--") != 0)
+				option = "--" + option;
+			if (option == "--config" || option == "--scenario")
+				return where + "The option \'" + option + "\' cannot be in a config file.";
+			std::string error = check(option, value);
+			if (!error.empty())
+				return where + error;
+			if (!in_section.insert(option).second)
+				return where + "The option \'" + option + "\' is given twice.";
+
+			if (section.empty())
+				common.push_back(std::make_pair(option, value));
+			else if (section == scenario)
+				chosen.push_back(std::make_pair(option, value));
+		}
+
+		if (!found)
+			return "There is no scenario \'" + scenario + "\' in \'" + name + "\'";
+		for (auto& option : chosen)
+			parser.addOption(option.first, option.second);
+		for (auto& option : common)
+			parser.addOption(option.first, option.second);
+		return "";
+	}
+
+	/* \retrun the value of option name, its default if not given, "" if it has none */
+	std::string text(const CLParser& parser, const std::string& name) const
+	{
+		const option_spec_t *o = find(name);
+		if (parser.optionExists(name))
+			return parser.optionValue(name);
+		return o != NULL && o->def != NULL? std::string(o->def): std::string("");
+	}
+
+	/* \retrun the value of the OPT_CHOICE option name in lower case, as in
+	 * its choices, given or defaulted
+	 */
+	std::string choice(const CLParser& parser, const std::string& name) const
+	{
+		return lower(text(parser, name));
+	}
+
+	/* \retrun the items of the OPT_LIST option name, given or defaulted */
+	std::vector<std::string> items(const CLParser& parser, const std::string& name) const
+	{
+		return split(text(parser, name));
+	}
+
+	/* \retrun the value of the OPT_INT option name, 0 if neither given nor defaulted */
+	long number(const CLParser& parser, const std::string& name) const
+	{
+		return std::strtol(text(parser, name).c_str(), NULL, 10);
+	}
+
+	/* \retrun the options part of --help */
+	std::string help() const
+	{
+		std::string mandatory, optional;
+		for (size_t i=0; i!=n; i++)
+			(table[i].mandatory? mandatory: optional) += usage(table[i]);
+		return "Mandatory arguments: only need one (ordered by precedence)\n" + mandatory +
+			"\nOptional arguments:\n" + optional;
+	}
+};
+
+#endif
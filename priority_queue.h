@@ -1,16 +1,33 @@
 #ifndef PRIORITY_QUEUE_H
 #define PRIORITY_QUEUE_H
 
+#include <algorithm>
 #include <assert.h>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 /* my implementation of red-black tree priority-queue. 
  * Based on Chapter 13 of Introduction to Algorithms by Cormen et al. 
+ *
+ * The order is given by KeyOf, which maps an element to an unsigned
+ * integer key (KeyOf::key_t). The key is computed once, when the element
+ * is pushed, and kept in its node, so walking the tree is one integer
+ * compare per level and never reads the element itself. Smaller keys pop
+ * first; equal keys pop in the order they were pushed.
+ *
+ * push_bulk() takes a batch, such as the processes arriving at the same
+ * tick. It sorts the batch once; if it is large next to the tree, it is
+ * merged with the nodes of the tree in order and the tree is built again
+ * balanced from the merge, in time linear in both, otherwise its nodes
+ * are inserted one by one.
  */
-template <typename T, class Compare = std::less<typename T::value_type> >
+template <typename T, class KeyOf>
 class priority_queue 
 {
 private:
+	typedef typename KeyOf::key_t key_t;
+
 	enum Color {
 		RED,
 		BLACK
@@ -26,8 +43,9 @@ private:
 			left = right = parent = NULL;
 		}
 
-		node(T data)
+		node(key_t key, T data)
 		{
+			this->key = key;
 			this->data = data;
 			color = RED;
 			left = right = parent = NULL;
@@ -65,7 +83,7 @@ private:
 				return nil;
 		}
 		
-		size_t count;
+		key_t key;
 		T data;
 		Color color;
 		node *left, *right, *parent; 
@@ -202,8 +220,7 @@ private:
 		while (x != nil)
 		{
 			y = x;
-			int c = cmp(z->data, x->data);
-			if (c > 0) // x > z
+			if (z->key < x->key) // x > z
 				x = x->left;
 			else
 				x = x->right;
@@ -215,8 +232,7 @@ private:
 			root = z;
 		else
 		{
-			int c = cmp(z->data, y->data);
-		 	if (c > 0) // y > z
+		 	if (z->key < y->key) // y > z
 				y->left = z;
 			else
 				y->right = z;
@@ -362,6 +378,49 @@ private:
 			delete_fixup(x);
 	}
 
+	/* builds a balanced tree of the n nodes of all, which are in order.
+	 * The nodes at depth red_depth are red, the others black, so every
+	 * path has as many black nodes.
+	 */
+	node *build(node **all, size_t n, node *parent, size_t depth, size_t red_depth)
+	{
+		if (n == 0)
+			return nil;
+
+		size_t mid = n/2;
+		node *z = all[mid];
+		z->parent = parent;
+		z->color = depth == red_depth? RED: BLACK;
+		z->left = build(all, mid, z, depth+1, red_depth);
+		z->right = build(all+mid+1, n-mid-1, z, depth+1, red_depth);
+		return z;
+	}
+
+	/* merges batch, sorted, with the nodes of the tree and builds it again */
+	void rebuild(std::vector<node*>& batch)
+	{
+		std::vector<node*> all;
+		all.reserve(sz + batch.size());
+
+		/* on equal keys the nodes of the tree were pushed first */
+		node *n = root == nil? nil: tree_minimum(root);
+		for (node *b : batch)
+		{
+			for (; n != nil && !(b->key < n->key); n = n->successor(nil))
+				all.push_back(n);
+			all.push_back(b);
+		}
+		for (; n != nil; n = n->successor(nil))
+			all.push_back(n);
+
+		/* the deepest level of a tree of all.size() nodes */
+		size_t red_depth = 0;
+		for (size_t k=all.size(); k>1; k>>=1)
+			red_depth++;
+
+		root = build(all.data(), all.size(), nil, 0, red_depth);
+		root->color = BLACK;
+	}
 	
 	class RBIterator 
 	{
@@ -411,10 +470,12 @@ private:
 	};
 
 public:
-	priority_queue() 
+	typedef KeyOf key_of_t;
+
+	priority_queue(const KeyOf& k = KeyOf()) 
 	{ 
 		sz = 0;
-		cmp = Compare(); // function used to compare two nodes
+		key_of = k; // function giving the key of an element
 		nil = new node(); // node with color == black
 		root = nil; // root initialized to nil
 		
@@ -424,13 +485,50 @@ public:
 	
 	void push(const T& val)
 	{
-		node *n = new node(val);
+		node *n = new node(key_of(val), val);
 		insert(n);
 		sz++;
 
 		assert(sz>0);
 	}
 
+	/* pushes every element of [first, last), in the same order as pushing
+	 * them one at a time would
+	 */
+	template<typename I>
+	void push_bulk(I first, I last)
+	{
+		typedef std::pair<key_t, T> entry_t;
+		auto by_key = [](const entry_t& lhs, const entry_t& rhs) { return lhs.first < rhs.first; };
+
+		/* sorted by key before the nodes are made, so the compares read
+		 * the entries in a row rather than nodes all over the heap
+		 */
+		std::vector<entry_t> entries;
+		for (; first != last; ++first)
+			entries.push_back(entry_t(key_of(*first), *first));
+		if (!std::is_sorted(entries.begin(), entries.end(), by_key))
+			std::stable_sort(entries.begin(), entries.end(), by_key);
+
+		std::vector<node*> batch;
+		batch.reserve(entries.size());
+		for (const entry_t& e : entries)
+			batch.push_back(new node(e.first, e.second));
+
+		/* inserting costs a walk down the tree per node, rebuilding a node
+		 * of the tree or the batch each
+		 */
+		size_t depth = 1;
+		for (size_t k=sz+batch.size(); k>1; k>>=1)
+			depth++;
+		if (batch.size() * depth >= sz)
+			rebuild(batch);
+		else
+			for (node *n : batch)
+				insert(n);
+		sz += batch.size();
+	}
+
 	void pop()
 	{
 		if (sz)
@@ -439,7 +537,6 @@ public:
 			delete_node(n);
 			sz--;		
 		}
-		assert(sz >= 0);
 	}
 
 	size_t size()
@@ -482,13 +579,13 @@ public:
 
 	iterator search(T data)
 	{
+		key_t key = key_of(data);
 		node *n = root;
 		while(n != nil)
 		{
-			int c = cmp(data, n->data);
-			if (c == 0)
+			if (key == n->key)
 				return RBIterator(nil, n);
-			else if (c < 0) // data > n->data
+			else if (key > n->key) // data > n->data
 				n = n->right;
 			else
 				n = n->left;
@@ -499,7 +596,7 @@ public:
 
 private:
 	node *root, *nil;
-	Compare cmp;
+	KeyOf key_of;
 	size_t sz;
 };
 
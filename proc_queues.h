@@ -2,175 +2,1019 @@
 #define PROC_QUEUES_H
 
 #include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <ctime>
 #include <cstdio>
 #include <cstdlib>
+#include <deque>
 #include <fstream>
 #include <list>
+#include <map>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "PCB.h"
 #include "priority_queue.h"
+#include "simd.h"
 
 /**************************************************************
- ************************* COMPARATORS ************************
+ ************************ ORDERING KEYS ***********************
  *************************************************************/
 
-/* comparator object to order the new queue on arrival times.
+/* The queues are ordered on one unsigned integer per element, computed
+ * when the element is pushed: the fields the scheduler orders on are
+ * packed into it from the most to the least significant, each one as an
+ * unsigned value which is smaller for the element which pops first.
+ * Clock takes 64 bits, so the order stays right however long the run is
+ * (a CLOCK_LAST push is simply the largest clock), and the PID fills the
+ * low 32 bits to break ties.
+ */
+typedef unsigned __int128 key128_t;
+
+/* the queues hold indices into a proc_table_t, so every key object
+ * keeps a pointer to the table it reads.
+ */
+class mykey_base
+{
+protected:
+	const proc_table_t *tbl;
+
+public:
+	mykey_base(const proc_table_t *tbl = NULL)
+	{
+		this->tbl = tbl;
+	}
+};
+
+/* key object to order the new queue on arrival times.
  * ties are broken with PID
- * \ret +ve if lhs pops before rhs; -ve if rhs pops before lhs
  */
-class mycmp_new
+class mykey_new : public mykey_base
 {
 public:
-	int operator() (const PCB& lhs, const PCB &rhs) const
+	using mykey_base::mykey_base;
+	typedef uint64_t key_t;
+
+	key_t operator() (pidx_t x) const
 	{
-		if (lhs.arr != rhs.arr)
-			return rhs.arr - lhs.arr;
-		else
-			return rhs.pid - lhs.pid;
+		return ((key_t) (uint32_t) tbl->arr[x] << 32) | (uint32_t) tbl->pid[x];
 	}
 };
 
-/* comparator object to order the priority queue.
+/* key object to order the priority queue.
  * Larger priority number implies higher priority
  * 0-49 = user processes
  * 50-99 = kernel processes
  * Ties are broken with order of arrival
- * \ret +ve if lhs pops before rhs; -ve if rhs pops before lhs
  */
-class mycmp_priority
+class mykey_priority : public mykey_base
 {
 public:
-	int operator() (const PCB& lhs, const PCB& rhs) const
+	using mykey_base::mykey_base;
+	typedef key128_t key_t;
+
+	key_t operator() (pidx_t x) const
 	{
-		if (lhs.pri != rhs.pri)
-			return lhs.pri - rhs.pri;
-		else if (rhs.Clock != lhs.Clock)
-			return rhs.Clock - lhs.Clock;
-		else
-			return rhs.pid - lhs.pid;
+		return ((key_t) (uint8_t) ~tbl->pri[x] << 96) 
+				 | ((key_t) tbl->Clock[x] << 32) | (uint32_t) tbl->pid[x];
+	}
+};
+
+/* key object to order the priority queue in FIFO order */
+class mykey_fifo : public mykey_base
+{
+public:
+	using mykey_base::mykey_base;
+	typedef key128_t key_t;
+
+	key_t operator() (pidx_t x) const
+	{
+		return ((key_t) tbl->Clock[x] << 32) | (uint32_t) tbl->pid[x];
+	}
+};
+
+/* key object to order the priority queue in SJF order */
+class mykey_sjf : public mykey_base
+{
+public:
+	using mykey_base::mykey_base;
+	typedef key128_t key_t;
+
+	key_t operator() (pidx_t x) const
+	{
+		return ((key_t) (uint32_t) tbl->bst[x] << 96) 
+				 | ((key_t) tbl->Clock[x] << 32) | (uint32_t) tbl->pid[x];
+	}
+};
+
+/* key object to order the priority queue in EDF order */
+class mykey_edf : public mykey_base
+{
+public:
+	using mykey_base::mykey_base;
+	typedef uint64_t key_t;
+
+	key_t operator() (pidx_t x) const
+	{
+		return ((key_t) (uint32_t) tbl->dline[x] << 32) | (uint32_t) tbl->pid[x];
 	}
 };
 
-/* comparator object to order the priority queue in FIFO order 
- * \ret +ve if lhs pops before rhs; -ve if rhs pops before lhs
+/* key object for the processes which age at the same tick. They are
+ * aged earliest Clock first. If clock times are tied, then broken
+ * by priority and then by PID.
  */
-class mycmp_fifo
+class mykey_age : public mykey_base
 {
 public:
-	int operator() (const PCB& lhs, const PCB& rhs) const
+	using mykey_base::mykey_base;
+	typedef key128_t key_t;
+
+	key_t operator() (pidx_t x) const
 	{
-		if (rhs.Clock != lhs.Clock)
-			return rhs.Clock - lhs.Clock;
-		else
-			return rhs.pid - lhs.pid;		
+		/* map 0-49 to [0,99] (even) 
+		 * map 50-99 to [0,99] (odd)
+		 * preserve order.
+		 */
+		uint32_t pri = tbl->pri[x];
+		pri = pri < 50? pri*2: (pri-50)*2 + 1;
+
+		return ((key_t) tbl->Clock[x] << 39) | ((key_t) pri << 32) | (uint32_t) tbl->pid[x];
 	}
 };
 
-/* comparator object to order the priority queue in SJF order 
- * \ret +ve if lhs pops before rhs; -ve if rhs pops before lhs
+
+/* key object for a lane of lazy_ready_t: processes of one class pushed
+ * at ticks equal modulo age_time. They all age on the same ticks, so at
+ * any time they pop in the order of pri - age_val*(Clock/age_time), with
+ * ties broken by PID.
  */
-class mycmp_sjf
+class mykey_lane : public mykey_base
 {
+private:
+	size_t age_time;
+	uint64_t age_val;
+
 public:
-	int operator() (const PCB& lhs, const PCB& rhs) const
+	typedef key128_t key_t;
+
+	mykey_lane(const proc_table_t *tbl = NULL, size_t age_time = 1, int age_val = 0)
+		: mykey_base(tbl)
 	{
-		if (lhs.bst != rhs.bst)
-			return rhs.bst - lhs.bst;
-		else if (rhs.Clock != lhs.Clock)
-			return rhs.Clock - lhs.Clock;
-		else
-			return rhs.pid - lhs.pid;
+		this->age_time = age_time;
+		this->age_val = age_val;
+	}
+
+	key_t operator() (pidx_t x) const
+	{
+		key_t level = (key_t) age_val * (tbl->Clock[x] / age_time) + (uint8_t) ~tbl->pri[x];
+		return (level << 32) | (uint32_t) tbl->pid[x];
 	}
 };
 
-/* comparator object to order the priority queue in EDF order */
-class mycmp_edf
+
+/* key object for the children of a group in group_ready_t: least
+ * virtual time first, ties broken by group index
+ */
+class mykey_group
 {
+private:
+	const group_tree_t *groups;
+
 public:
-	int operator() (const PCB& lhs, const PCB& rhs) const
+	typedef key128_t key_t;
+
+	mykey_group(const group_tree_t *groups = NULL)
 	{
-		if (lhs.dline != rhs.dline)
-			return rhs.dline - lhs.dline;
-		else
-			return rhs.pid - lhs.pid;
+		this->groups = groups;
+	}
+
+	key_t operator() (uint32_t g) const
+	{
+		return ((key_t) groups->vtime[g] << 32) | g;
+	}
+};
+
+
+/*******************************************************************
+ ******************************* TYPES *****************************
+ ******************************************************************/
+
+/* The new queue never changes order once the file is read, so it is
+ * kept as a sorted array of indices and a cursor to the next arrival.
+ */
+struct new_t
+{
+	typedef std::vector<pidx_t>::const_iterator iterator;
+
+	std::vector<pidx_t> order;
+	size_t cursor;
+
+	new_t()
+	{
+		cursor = 0;
+	}
+
+	pidx_t top() const
+	{
+		return order[cursor];
+	}
+
+	void pop()
+	{
+		cursor++;
+	}
+
+	bool empty() const
+	{
+		return cursor == order.size();
+	}
+
+	size_t size() const
+	{
+		return order.size() - cursor;
+	}
+
+	iterator begin() const
+	{
+		return order.begin() + cursor;
+	}
+
+	iterator end() const
+	{
+		return order.end();
 	}
 };
 
-/* comparator object for age_t. The front of the age_q has the
- * earliest Clock time. If clock times are tied, then broken
- * by priority. The important point is that user processes with
- * priority 49 and kernel processes with priority 99 will always
- * be popped only after all other processes have been popped.
- * \ret +ve if lhs pops before rhs; -ve if rhs pops before lhs
+typedef priority_queue<pidx_t, mykey_priority> priority_t;
+typedef priority_queue<pidx_t, mykey_fifo> fifo_t;
+typedef priority_queue<pidx_t, mykey_sjf> sjf_t;
+typedef priority_queue<pidx_t, mykey_edf> edf_t;
+
+#define AGE_RING_MAX 65536 // most lists kept by ready_age_t, whatever the age_time
+
+/* Ready queue with the processes grouped by the tick they were pushed.
+ * A process ages exactly age_time ticks after it was pushed, so the
+ * groups are kept in a ring of age_time lists, list Clock % age_time
+ * holding the processes pushed at Clock. Every tick only the list which
+ * is due is walked, so ageing costs as much as the processes which age.
+ * The lists are threaded through next/prev by process index, which makes
+ * dropping a dispatched process O(1). Maxed processes never age and are
+ * not in any list; with age_time 0 there are no lists at all.
  */
 template<typename T>
-class mycmp_age
+struct ready_age_t
+{
+	T ready_q;
+	const proc_table_t *tbl;
+	size_t age_time;
+	std::vector<pidx_t> ring; // first process of each list
+	std::vector<pidx_t> next, prev; // links of the lists
+
+	/* age_val is only needed by lazy_ready_t */
+	ready_age_t(const proc_table_t& tbl, int age_time, int = 0)
+		: ready_q(typename T::key_of_t(&tbl))
+	{
+		this->tbl = &tbl;
+		this->age_time = age_time > 0? age_time: 0;
+		if (this->age_time)
+		{
+			ring.assign(std::min(this->age_time, (size_t) AGE_RING_MAX), NO_PROC);
+			next.assign(tbl.size(), NO_PROC);
+			prev.assign(tbl.size(), NO_PROC);
+		}
+	}
+
+	/* fill from the ready queue of any scheduler. The keys are in the
+	 * process table, so only the indices are carried over.
+	 */
+	template<typename R>
+	void assign(const R& other)
+	{
+		other.for_each([this](pidx_t x) { push(x); });
+	}
+
+	void push(pidx_t x)
+	{
+		ready_q.push(x);
+		if (ages(x))
+			link(x);
+	}
+
+	/* pushes every process of [first, last) at once, see
+	 * priority_queue::push_bulk()
+	 */
+	template<typename I>
+	void push_bulk(I first, I last)
+	{
+		ready_q.push_bulk(first, last);
+		for (; first != last; ++first)
+			if (ages(*first))
+				link(*first);
+	}
+
+	void pop()
+	{
+		pidx_t x = ready_q.top();
+		ready_q.pop();
+		if (ages(x))
+			unlink(x);
+	}
+
+	/* remove any process of the ready queue */
+	void erase(pidx_t x)
+	{
+		ready_q.erase(ready_q.search(x));
+		if (ages(x))
+			unlink(x);
+	}
+
+	/* appends to aged the processes which were pushed age_time or more
+	 * ticks before Clock, in the order they are to be aged. More than one
+	 * tick shares a list once age_time is over AGE_RING_MAX.
+	 */
+	void expired(size_t Clock, std::vector<pidx_t>& aged)
+	{
+		if (!age_time || Clock < age_time)
+			return;
+
+		size_t first = aged.size();
+		for (pidx_t x=ring[(Clock - age_time) % ring.size()]; x!=NO_PROC; x=next[x])
+			if (tbl->Clock[x] + age_time <= Clock)
+				aged.push_back(x);
+
+		mykey_age key(tbl);
+		std::sort(aged.begin() + first, aged.end(),
+							[&key](pidx_t lhs, pidx_t rhs) { return key(lhs) < key(rhs); });
+	}
+
+	pidx_t top()
+	{
+		return ready_q.top();
+	}
+
+	bool empty()
+	{
+		return ready_q.empty();
+	}
+
+	size_t size()
+	{
+		return ready_q.size();
+	}
+
+	/* calls f on every process in the queue */
+	template<typename F>
+	void for_each(F f) const
+	{
+		for (auto iter=ready_q.begin(); iter!=ready_q.end(); iter++)
+			f(*iter);
+	}
+
+	/* the table is always up to date, see lazy_ready_t::sync() */
+	void sync()
+	{
+	}
+
+	void sync(pidx_t)
+	{
+	}
+
+	/* only group_ready_t keeps the cpu used */
+	void charge(pidx_t, int)
+	{
+	}
+
+	/* only group_ready_t hides throttled processes, see bandwidth_t */
+	void throttle(uint32_t, int, bool)
+	{
+	}
+
+	size_t throttled() const
+	{
+		return 0;
+	}
+
+	/* would x be dispatched before y, were both in the queue? */
+	bool before(pidx_t x, pidx_t y) const
+	{
+		typename T::key_of_t key(tbl);
+		return key(x) < key(y);
+	}
+
+private:
+	bool ages(pidx_t x) const
+	{
+		return age_time && tbl->Clock[x] != CLOCK_LAST;
+	}
+
+	void link(pidx_t x)
+	{
+		pidx_t& head = ring[tbl->Clock[x] % ring.size()];
+		prev[x] = NO_PROC;
+		next[x] = head;
+		if (head != NO_PROC)
+			prev[head] = x;
+		head = x;
+	}
+
+	void unlink(pidx_t x)
+	{
+		if (prev[x] != NO_PROC)
+			next[prev[x]] = next[x];
+		else
+			ring[tbl->Clock[x] % ring.size()] = next[x];
+		if (next[x] != NO_PROC)
+			prev[next[x]] = prev[x];
+	}
+};
+
+/* Ready queue of the priority scheduler when ageing is lazy. A process
+ * pushed at c with priority p has, at tick t, aged k = (t-c)/age_time
+ * times: its priority is p + k*age_val (up to 49 or 99) and it was last
+ * pushed at c + k*age_time. Processes of the same class pushed at ticks
+ * equal modulo age_time (a lane) age on the same ticks, so their order
+ * never changes and is given by mykey_lane. Only the head of each lane
+ * is kept in the front queue, with the maxed processes, and each tick
+ * only the lanes due re-key their head. Ageing thus never touches a
+ * process, except once when it maxes out. The table has the pri and
+ * Clock of a process as of its last push or lane head change; sync()
+ * brings them up to date for the whole queue.
+ */
+class lazy_ready_t
 {
+private:
+	typedef priority_queue<pidx_t, mykey_lane> lane_t;
+
+	proc_table_t *tbl;
+	size_t age_time;
+	int age_val;
+	size_t now; // the last tick aged
+	size_t count;
+	priority_t front; // maxed processes and the head of every lane
+	std::map<size_t, lane_t> lanes[2]; // user and kernel lanes, by Clock % age_time
+
+	lane_t& lane_of(pidx_t x)
+	{
+		std::map<size_t, lane_t>& m = lanes[tbl->pri[x] >= 50];
+		size_t r = tbl->Clock[x] % age_time;
+
+		auto iter = m.find(r);
+		if (iter == m.end())
+			iter = m.emplace(std::piecewise_construct, std::forward_as_tuple(r),
+											 std::forward_as_tuple(mykey_lane(tbl, age_time, age_val))).first;
+		return iter->second;
+	}
+
+	/* brings the pri and Clock of x to what do_aging would have made them
+	 * by tick when. A process which maxes out is parked at CLOCK_LAST.
+	 */
+	void materialize(pidx_t x, size_t when)
+	{
+		size_t c = tbl->Clock[x];
+		if (c == CLOCK_LAST || when <= c)
+			return;
+
+		uint64_t k = (when - c) / age_time;
+		if (k == 0)
+			return;
+
+		int pri = tbl->pri[x];
+		int max = pri >= 50? 99: 49;
+		if (age_val != 0 && k >= (uint64_t) ((max - pri + age_val - 1) / age_val))
+		{
+			tbl->pri[x] = (uint8_t) max;
+			tbl->Clock[x] = CLOCK_LAST;
+		}
+		else
+		{
+			tbl->pri[x] = (uint8_t) (pri + age_val*k);
+			tbl->Clock[x] = c + k*age_time;
+		}
+	}
+
 public:
-	int operator() (const T& lhs, const T& rhs) const
-	{
-		if (lhs->Clock != rhs->Clock)
-			return rhs->Clock - lhs->Clock;
-		else if (lhs->pri != rhs->pri)
-		{ 
-			/* map 0-49 to [0,99] (even) 
-			 * map 50-99 to [0,99] (odd)
-			 * preserve order.
-			 * This way the last node has original pri=99 and new pri=99
-			 * and second-last has original pri=49 and new pri=98, etc
-			 */
-			int lpri, rpri;
-
-			lpri = lhs->pri;
-			if (lpri < 50)
-				lpri *= 2;
-			else
-				lpri = (lpri-50)*2 + 1;
+	lazy_ready_t(proc_table_t& tbl, int age_time, int age_val)
+		: front(mykey_priority(&tbl))
+	{
+		this->tbl = &tbl;
+		this->age_time = age_time > 0? age_time: 1;
+		this->age_val = age_val;
+		now = 0;
+		count = 0;
+	}
+
+	template<typename R>
+	void assign(const R& other)
+	{
+		other.for_each([this](pidx_t x) { push(x); });
+	}
+
+	void push(pidx_t x)
+	{
+		count++;
+		materialize(x, now);
+		if (tbl->Clock[x] == CLOCK_LAST)
+		{
+			front.push(x);
+			return;
+		}
+
+		lane_t& lane = lane_of(x);
+		pidx_t head = lane.empty()? NO_PROC: lane.top();
+		lane.push(x);
+		if (lane.top() == x)
+		{
+			if (head != NO_PROC)
+				front.erase(front.search(head));
+			front.push(x);
+		}
+	}
+
+	/* pushes every process of [first, last) at once. Each lane takes its
+	 * processes in one batch, and its head in the front only changes once.
+	 * Processes arriving at the same tick are all in one lane per class.
+	 */
+	template<typename I>
+	void push_bulk(I first, I last)
+	{
+		std::vector<pidx_t> maxed;
+		std::map<std::pair<int, size_t>, std::vector<pidx_t> > by_lane;
 
-			rpri = rhs->pri;
-			if (rpri < 50)
-				rpri *= 2;
+		for (; first != last; ++first)
+		{
+			pidx_t x = *first;
+			count++;
+			materialize(x, now);
+			if (tbl->Clock[x] == CLOCK_LAST)
+				maxed.push_back(x);
 			else
-				rpri = (rpri-50)*2 + 1;
+				by_lane[std::make_pair(tbl->pri[x] >= 50, tbl->Clock[x] % age_time)].push_back(x);
+		}
 
-			return rpri - lpri;
+		for (auto& batch : by_lane)
+		{
+			lane_t& lane = lane_of(batch.second.front());
+			pidx_t head = lane.empty()? NO_PROC: lane.top();
+			lane.push_bulk(batch.second.begin(), batch.second.end());
+			if (lane.top() != head)
+			{
+				if (head != NO_PROC)
+					front.erase(front.search(head));
+				front.push(lane.top());
+			}
 		}
-		else
-			return rhs->pid - lhs->pid;
+		front.push_bulk(maxed.begin(), maxed.end());
+	}
+
+	void pop()
+	{
+		pidx_t x = front.top();
+		front.pop();
+		count--;
+		if (tbl->Clock[x] == CLOCK_LAST)
+			return;
+
+		lane_t& lane = lane_of(x);
+		lane.pop(); // x was its head
+		if (!lane.empty())
+		{
+			materialize(lane.top(), now);
+			front.push(lane.top());
+		}
+	}
+
+	/* ages the lanes due at Clock. If aged is given, the processes which
+	 * aged are appended to it in the order do_aging would age them.
+	 */
+	void age(size_t Clock, std::vector<pidx_t> *aged)
+	{
+		std::vector<std::pair<mykey_age::key_t, pidx_t> > due;
+		mykey_age key(tbl);
+
+		now = Clock;
+		for (int kernel=0; kernel!=2; kernel++)
+		{
+			auto iter = lanes[kernel].find(Clock % age_time);
+			if (iter == lanes[kernel].end() || iter->second.empty())
+				continue;
+
+			/* the head is re-keyed, so it leaves the front while its keys are the old ones */
+			lane_t& lane = iter->second;
+			front.erase(front.search(lane.top()));
+
+			if (aged)
+				for (auto i=lane.begin(); i!=lane.end(); i++)
+					if (tbl->Clock[*i] < Clock) // not pushed at this tick
+					{
+						materialize(*i, Clock-1);
+						due.push_back(std::make_pair(key(*i), *i));
+					}
+
+			/* the ones maxing out come first in the lane and move to the front */
+			while (!lane.empty())
+			{
+				pidx_t x = lane.top();
+				materialize(x, Clock);
+				if (tbl->Clock[x] != CLOCK_LAST)
+					break;
+				lane.pop();
+				front.push(x);
+			}
+
+			if (!lane.empty())
+				front.push(lane.top());
+		}
+
+		if (aged)
+		{
+			std::sort(due.begin(), due.end());
+			for (auto& d : due)
+				aged->push_back(d.second);
+		}
+	}
+
+	pidx_t top()
+	{
+		return front.top();
+	}
+
+	bool empty()
+	{
+		return count == 0;
+	}
+
+	size_t size()
+	{
+		return count;
+	}
+
+	template<typename F>
+	void for_each(F f) const
+	{
+		for (int kernel=0; kernel!=2; kernel++)
+			for (auto& l : lanes[kernel])
+				for (auto iter=l.second.begin(); iter!=l.second.end(); iter++)
+					f(*iter);
+		for (auto iter=front.begin(); iter!=front.end(); iter++)
+			if (tbl->Clock[*iter] == CLOCK_LAST)
+				f(*iter);
+	}
+
+	/* writes the current pri and Clock of every process in the queue to
+	 * the table. Their order does not change.
+	 */
+	void sync()
+	{
+		for (int kernel=0; kernel!=2; kernel++)
+			for (auto& l : lanes[kernel])
+				for (auto iter=l.second.begin(); iter!=l.second.end(); iter++)
+					materialize(*iter, now);
+	}
+
+	/* the same for one process, which must be in the queue */
+	void sync(pidx_t x)
+	{
+		materialize(x, now);
+	}
+
+	/* see ready_age_t::charge() */
+	void charge(pidx_t, int)
+	{
+	}
+
+	/* see ready_age_t::throttle() */
+	void throttle(uint32_t, int, bool)
+	{
+	}
+
+	size_t throttled() const
+	{
+		return 0;
+	}
+
+	/* the same for two processes at the head of their lanes */
+	bool before(pidx_t x, pidx_t y) const
+	{
+		mykey_priority key(tbl);
+		return key(x) < key(y);
 	}
 };
 
+/* Ready queue of a scheduler run in groups (see group_tree_t). Each
+ * leaf group has a ready queue R of its own, ordered by the scheduler,
+ * and each group above the leaves has a queue of its children which have
+ * ready processes, least virtual time first. The next process is the top
+ * of the leaf reached by taking the first child from the root down, so
+ * picking one costs O(log children) per level, whatever the number of
+ * processes. A process charges the ticks it ran to its group and the
+ * groups above it when it leaves the cpu (charge()).
+ *
+ * The processes of a group or class whose cpu quota is used up (see
+ * bandwidth_t) stay in their queues but are hidden: a throttled group
+ * leaves the queue of its parent, and with limits on classes each leaf
+ * has a queue per class, kernel and user, merged by R's order while
+ * neither is throttled. Throttling thus costs the same whatever the
+ * number of processes it holds back. count only has the processes which
+ * are not hidden; empty(), size() and top() only see those.
+ */
+template<typename R>
+class group_ready_t
+{
+private:
+	typedef priority_queue<uint32_t, mykey_group> children_t;
+
+	proc_table_t *tbl;
+	group_tree_t *groups;
+	std::deque<R> queues; // of each group and class, user at 2g and kernel at 2g+1
+	std::deque<children_t> active; // children of each group with ready processes
+	std::vector<size_t> count; // ready processes in each group and below
+	std::vector<uint32_t> hidden; // throttled limits of each group
+	uint32_t class_hidden[2]; // throttled limits of user and kernel
+	size_t total; // with the hidden ones
 
-/*******************************************************************
- ******************************* TYPES *****************************
- ******************************************************************/
-typedef priority_queue<PCB, mycmp_new> new_t;
-typedef priority_queue<PCB, mycmp_priority> priority_t;
-typedef priority_queue<PCB, mycmp_fifo> fifo_t;
-typedef priority_queue<PCB, mycmp_sjf> sjf_t;
-typedef priority_queue<PCB, mycmp_edf> edf_t;
-typedef std::list<PCB> io_t;
+	/* the leaf the next process is in */
+	uint32_t leaf()
+	{
+		uint32_t g = ROOT_GROUP;
+		while (!active[g].empty())
+			g = active[g].top();
+		return g;
+	}
+
+	/* the queue of x in its leaf */
+	R& queue_of(pidx_t x)
+	{
+		return queues[2*tbl->group[x] + (groups->by_class && tbl->pri[x] >= 50)];
+	}
+
+	/* the queue of leaf g the next process is in */
+	R& first(uint32_t g)
+	{
+		R& user = queues[2*g];
+		R& kernel = queues[2*g + 1];
+		bool u = !class_hidden[0] && !user.empty();
+		bool k = !class_hidden[1] && !kernel.empty();
+
+		if (u && k)
+			return kernel.before(kernel.top(), user.top())? kernel: user;
+		return k? kernel: user;
+	}
+
+	/* adds delta to the ready processes of g and the groups above it. A
+	 * group which had none starts at the floor of its parent, with the
+	 * cpu it got while idle forgotten; a hidden one is not seen above.
+	 */
+	void adjust(uint32_t g, ptrdiff_t delta)
+	{
+		for (;;)
+		{
+			bool had = count[g] != 0;
+			count[g] += delta;
+			if (g == ROOT_GROUP || hidden[g])
+				return;
+
+			uint32_t up = groups->parent[g];
+			if (!had && count[g] != 0)
+			{
+				groups->vtime[g] = std::max(groups->vtime[g], groups->floor[up]);
+				active[up].push(g);
+			}
+			else if (had && count[g] == 0)
+				active[up].erase(active[up].search(g));
+			g = up;
+		}
+	}
+
+public:
+	/* age_val is only needed by lazy_ready_t */
+	group_ready_t(proc_table_t& tbl, int age_time, int age_val = 0)
+	{
+		this->tbl = &tbl;
+		groups = &tbl.groups;
+		count.assign(groups->size(), 0);
+		hidden.assign(groups->size(), 0);
+		class_hidden[0] = class_hidden[1] = 0;
+		total = 0;
+		for (uint32_t g=0; g!=groups->size(); g++)
+		{
+			bool leaf = groups->is_leaf(g);
+			queues.emplace_back(tbl, leaf? age_time: 0, age_val);
+			queues.emplace_back(tbl, leaf && groups->by_class? age_time: 0, age_val);
+			active.emplace_back(mykey_group(groups));
+		}
+	}
+
+	template<typename Q>
+	void assign(const Q& other)
+	{
+		other.for_each([this](pidx_t x) { push(x); });
+	}
+
+	void push(pidx_t x)
+	{
+		queue_of(x).push(x);
+		total++;
+		if (!class_hidden[groups->by_class && tbl->pri[x] >= 50])
+			adjust(tbl->group[x], 1);
+	}
+
+	/* pushes every process of [first, last) at once: each queue takes its
+	 * processes in one batch, and the groups above it are adjusted once
+	 */
+	template<typename I>
+	void push_bulk(I first, I last)
+	{
+		std::map<size_t, std::vector<pidx_t> > by_queue;
+
+		for (; first != last; ++first)
+			by_queue[2*tbl->group[*first] + (groups->by_class && tbl->pri[*first] >= 50)].push_back(*first);
+
+		for (auto& batch : by_queue)
+		{
+			queues[batch.first].push_bulk(batch.second.begin(), batch.second.end());
+			total += batch.second.size();
+			if (!class_hidden[batch.first % 2])
+				adjust((uint32_t) (batch.first / 2), (ptrdiff_t) batch.second.size());
+		}
+	}
+
+	void pop()
+	{
+		uint32_t g = leaf();
+		first(g).pop();
+		total--;
+		for (uint32_t up=g; up!=ROOT_GROUP; up=groups->parent[up])
+			groups->floor[groups->parent[up]] = std::max(groups->floor[groups->parent[up]], groups->vtime[up]);
+		adjust(g, -1);
+	}
+
+	/* x ran ticks since it got the cpu */
+	void charge(pidx_t x, int ticks)
+	{
+		for (uint32_t g=tbl->group[x]; g!=ROOT_GROUP; g=groups->parent[g])
+		{
+			uint32_t up = groups->parent[g];
+			bool queued = count[g] != 0 && !hidden[g]; // its key changes
+			if (queued)
+				active[up].erase(active[up].search(g));
+			groups->vtime[g] += (uint64_t) ticks * GROUP_STRIDE / groups->shares[g];
+			if (queued)
+				active[up].push(g);
+		}
+	}
+
+	/* hides (on) or shows again the processes of group g, or of the class
+	 * kernel if g is NO_GROUP, for a limit which was throttled or
+	 * refreshed. A group shown again starts at the floor of its parent.
+	 */
+	void throttle(uint32_t g, int kernel, bool on)
+	{
+		if (g == NO_GROUP)
+		{
+			if (on? class_hidden[kernel]++ != 0: --class_hidden[kernel] != 0)
+				return;
+			for (uint32_t leaf=0; leaf!=groups->size(); leaf++)
+			{
+				ptrdiff_t n = queues[2*leaf + kernel].size();
+				if (n != 0)
+					adjust(leaf, on? -n: n);
+			}
+			return;
+		}
+
+		if (on? hidden[g]++ != 0: --hidden[g] != 0)
+			return;
+		if (count[g] == 0)
+			return;
+
+		uint32_t up = groups->parent[g];
+		if (on)
+		{
+			active[up].erase(active[up].search(g));
+			adjust(up, -(ptrdiff_t) count[g]);
+		}
+		else
+		{
+			groups->vtime[g] = std::max(groups->vtime[g], groups->floor[up]);
+			active[up].push(g);
+			adjust(up, count[g]);
+		}
+	}
+
+	/* \retrun the processes hidden by throttle() */
+	size_t throttled() const
+	{
+		return total - count[ROOT_GROUP];
+	}
+
+	pidx_t top()
+	{
+		return first(leaf()).top();
+	}
+
+	bool empty()
+	{
+		return count[ROOT_GROUP] == 0;
+	}
+
+	size_t size()
+	{
+		return count[ROOT_GROUP];
+	}
+
+	/* the ready queue of class kernel in leaf g, for ageing */
+	R& queue(uint32_t g, int kernel)
+	{
+		return queues[2*g + kernel];
+	}
+
+	/* calls f on every process in the queue, hidden or not */
+	template<typename F>
+	void for_each(F f) const
+	{
+		for (const R& q : queues)
+			q.for_each(f);
+	}
+
+	void sync()
+	{
+		for (R& q : queues)
+			q.sync();
+	}
 
-template<typename T> 
-using age_t = priority_queue<T, mycmp_age<T> >;
+	void sync(pidx_t x)
+	{
+		queue_of(x).sync(x);
+	}
+};
 
 /********************************************************************
  ***************************** FUNCTIONS ****************************
  *******************************************************************/
 
 /*******************************************************************/
-/*! This function returns the new_q from the process file.
+/*! This function reads the Phases column of a process: the ticks of
+		its cpu and io phases, one after the other and comma separated,
+		starting and ending with cpu, e.g. 5,20,3 for 5 ticks of cpu, 20 of
+		io and 3 of cpu.
+		\param str is the column
+		\param arena is where the phases are appended
+		\retrun false if the column is not such a list; nothing is then
+						appended
+*/
+/*******************************************************************/
+inline bool parse_phases(const char *str, std::vector<int32_t>& arena)
+{
+	size_t first = arena.size();
+	char *end;
+
+	for (;;)
+	{
+		long v = strtol(str, &end, 10);
+		if (end == str || v <= 0 || v > INT32_MAX)
+			break;
+		arena.push_back((int32_t) v);
+		str = end;
+		if (*str != ',')
+		{
+			while (isspace((unsigned char) *str))
+				str++;
+			if (*str == '\0' && (arena.size() - first) % 2 == 1)
+				return true;
+			break;
+		}
+		str++;
+	}
+	arena.resize(first);
+	return false;
+}
+
+/*******************************************************************/
+/*! This function returns the new_q from the process file. Lines are
+		Pid Bst Arr Pri Dline IO, optionally followed by Dev (the IO device)
+		and Pos (the position on it), both 0 if missing, Phases (see
+		parse_phases) and Group (see group_tree_t), both '-' if none. A
+		process with phases bursts for the total of its cpu phases,
+		whatever its Bst, and does the io of its phases in place of IO
+		ticks every quantum.
 		\param fname is the name of the file with the proceses
+		\param tbl is the process table the valid processes are added to
 		\retrun the queue of processes ordered by arrival time. Ties
 						broken by PID.
 */
 /*******************************************************************/
-new_t create_new_queue(std::string fname)
+inline new_t create_new_queue(std::string fname, proc_table_t& tbl)
 {
-	#define VALID(x) (x.pid>0 && x.bst>0 && x.arr>=0 && x.pri>=0 && x.pri<=99 && x.dline>0 && x.io>=0)
+	/* the file is read into raw columns first so it can be validated in bulk */
+	std::vector<int32_t> pid, bst, arr, pri, dline, io, dev, pos;
+	std::vector<int32_t> arena; // the phases of all the lines
+	std::vector<size_t> phase_at; // where the phases of each line start in arena
+	std::vector<std::string> group; // of each line, "" for the root
+	int x[8];
 
 	new_t new_q;
 	std::ifstream infile;
@@ -187,44 +1031,104 @@ new_t create_new_queue(std::string fname)
 	/* get the first line of titles */
 	std::getline(infile, line);
 
-#ifdef _DEBUG
-	int total_burst=0;
-#endif
-
 	/* parse */
 	while(std::getline(infile, line))
 	{
-		PCB x;
-		if (std::count(line.begin(), line.end(), '\t') == 5) /* avoid incomplete lines */
+		long tabs = std::count(line.begin(), line.end(), '\t');
+		if (tabs >= 5 && tabs <= 9) /* avoid incomplete lines */
 		{
+			x[6] = x[7] = 0;
 			sscanf(line.c_str(), 
-						"%i\t%i\t%i\t%i\t%i\t%i\n", 
-						&x.pid, 
-						&x.bst, 
-						&x.arr, 
-						&x.pri,
-						&x.dline,
-						&x.io);
-			x.Clock = 0;
-			if (VALID(x))
-				new_q.push(x);
+						"%i\t%i\t%i\t%i\t%i\t%i\t%i\t%i\n", 
+						&x[0], &x[1], &x[2], &x[3], &x[4], &x[5], &x[6], &x[7]);
+			phase_at.push_back(arena.size());
+			group.push_back("");
+			if (tabs >= 8)
+			{
+				size_t tab = line.find('\t');
+				for (int i=1; i!=8; i++)
+					tab = line.find('\t', tab+1);
+				size_t end = line.find('\t', tab+1);
+				std::string phases = line.substr(tab+1, end == std::string::npos? end: end-tab-1);
+				phases.erase(phases.find_last_not_of(" \r") + 1);
+				if (end != std::string::npos)
+				{
+					group.back() = line.substr(end+1);
+					group.back().erase(group.back().find_last_not_of(" \r") + 1);
+					if (group.back() == "-")
+						group.back().clear();
+				}
 
-#ifdef _DEBUG
-			if (VALID(x))
-				total_burst += x.bst;
-#endif			
+				/* invalid, whatever the rest */
+				if ((phases != "-" && !phases.empty() && !parse_phases(phases.c_str(), arena))
+						|| !group_tree_t::valid_path(group.back()))
+					x[1] = 0;
+			}
+			pid.push_back(x[0]);
+			bst.push_back(x[1]);
+			arr.push_back(x[2]);
+			pri.push_back(x[3]);
+			dline.push_back(x[4]);
+			io.push_back(x[5]);
+			dev.push_back(x[6]);
+			pos.push_back(x[7]);
 		}
 	}
+	infile.close();
+	phase_at.push_back(arena.size());
+
+	/* the burst of a process with phases is that of its cpu phases */
+	for (size_t i=0; i+1!=phase_at.size(); i++)
+		if (phase_at[i+1] != phase_at[i])
+		{
+			int64_t total = 0;
+			for (size_t j=phase_at[i]; j<phase_at[i+1]; j+=2)
+				total += arena[j];
+			bst[i] = total <= INT32_MAX? (int32_t) total: 0;
+		}
+
+	/* validate every row at once, then keep only the valid ones */
+	size_t n = pid.size();
+	std::vector<uint8_t> valid(n);
+	size_t nvalid = validate_columns(pid.data(), bst.data(), arr.data(), pri.data(), 
+																	 dline.data(), io.data(), valid.data(), n);
+	for (size_t i=0; i!=n; i++)
+		if (valid[i] && (dev[i] < 0 || pos[i] < 0))
+		{
+			valid[i] = 0;
+			nvalid--;
+		}
+
+	tbl.reserve(nvalid);
+	new_q.order.reserve(nvalid);
+	for (size_t i=0; i!=n; i++)
+		if (valid[i])
+		{
+			pidx_t y = tbl.add(pid[i], bst[i], arr[i], pri[i], dline[i], io[i], dev[i], pos[i]);
+			if (phase_at[i+1] != phase_at[i])
+				tbl.add_phases(y, &arena[phase_at[i]], phase_at[i+1] - phase_at[i]);
+			tbl.group[y] = tbl.groups.add_path(group[i]);
+			new_q.order.push_back(y);
+		}
+
+	/* only leaves hold processes */
+	for (pidx_t y=0; y!=tbl.size(); y++)
+		if (!tbl.groups.is_leaf(tbl.group[y]))
+			tbl.group[y] = tbl.groups.own(tbl.group[y]);
 
 #ifdef _DEBUG
-	std::cout << "Total Execution Time: " << total_burst << std::endl;
+	std::cout << "Total Execution Time: " << sum_column(tbl.bst.data(), tbl.size()) << std::endl;
 #endif
 
-	infile.close();
+	/* order on arrival. stable, so equal keys keep the order of the file */
+	mykey_new key(&tbl);
+	std::stable_sort(new_q.order.begin(), new_q.order.end(), 
+									 [&key](pidx_t lhs, pidx_t rhs) { return key(lhs) < key(rhs); });
+
 	return new_q;
 }
 
-void generate_test_cases(int how_many, bool has_io)
+inline void generate_test_cases(int how_many, bool has_io)
 {
 	std::ofstream testfs("test_cases");
 	++how_many;
@@ -0,0 +1,93 @@
+#ifndef SCHED_POLICY_H
+#define SCHED_POLICY_H
+
+#include "proc_queues.h"
+
+/* Compile-time description of a scheduler. run_scheduler<P> is
+ * instantiated once per policy and tests these constants instead of the
+ * scheduler chosen on the command line, so each instantiation only keeps
+ * the code its scheduler needs. A new scheduler is a key object, a queue
+ * type and one of these.
+ *
+ *   ready_t    the ready queue, ordered for the scheduler
+ *   AGING      processes which waited age_time ticks get promoted
+ *   IO         processes leave the cpu to do their io
+ *   DEADLINES  processes which cannot meet their deadline are aborted,
+ *              so waiting is counted per process to drop theirs
+ *   GROUPS     the processes are run in groups, see group_policy
+ */
+struct fifo_policy
+{
+	typedef ready_age_t<fifo_t> ready_t;
+	static const bool AGING = false;
+	static const bool IO = true;
+	static const bool DEADLINES = false;
+	static const bool GROUPS = false;
+};
+
+struct sjf_policy
+{
+	typedef ready_age_t<sjf_t> ready_t;
+	static const bool AGING = false;
+	static const bool IO = true;
+	static const bool DEADLINES = false;
+	static const bool GROUPS = false;
+};
+
+struct priority_policy
+{
+	typedef ready_age_t<priority_t> ready_t;
+	static const bool AGING = true;
+	static const bool IO = true;
+	static const bool DEADLINES = false;
+	static const bool GROUPS = false;
+};
+
+/* priority scheduler which ages lazily, see lazy_ready_t. Dispatches in
+ * the same order as priority_policy.
+ */
+struct lazy_priority_policy
+{
+	typedef lazy_ready_t ready_t;
+	static const bool AGING = true;
+	static const bool IO = true;
+	static const bool DEADLINES = false;
+	static const bool GROUPS = false;
+};
+
+struct edf_policy
+{
+	typedef ready_age_t<edf_t> ready_t;
+	static const bool AGING = false;
+	static const bool IO = false;
+	static const bool DEADLINES = true;
+	static const bool GROUPS = false;
+};
+
+/* the scheduler P run in the groups of the process file: the groups
+ * share the cpu by their shares, and P orders the processes of each
+ */
+template<typename P>
+struct group_policy
+{
+	typedef group_ready_t<typename P::ready_t> ready_t;
+	static const bool AGING = P::AGING;
+	static const bool IO = P::IO;
+	static const bool DEADLINES = P::DEADLINES;
+	static const bool GROUPS = true;
+};
+
+/* the policy of a branch with the scheduler Q of a run with P */
+template<typename Q, bool GROUPS>
+struct branch_policy
+{
+	typedef Q type;
+};
+
+template<typename Q>
+struct branch_policy<Q, true>
+{
+	typedef group_policy<Q> type;
+};
+
+#endif
@@ -0,0 +1,412 @@
+#ifndef SCHED_TRACE_H
+#define SCHED_TRACE_H
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/* Reads the sched_switch and sched_wakeup events of a Linux scheduler
+ * trace, as printed by ftrace (trace or trace_pipe) or by perf script,
+ * one line at a time, and turns every task in it into a process of the
+ * process file, with Phases (see create_new_queue): each time the task
+ * ran until it blocked is a cpu phase, and each time it slept until it
+ * was woken is an io phase. Time the task was runnable but not on a cpu
+ * is not a phase; it is what the schedulers decide.
+ *
+ * Both ways the events are printed are understood:
+ *
+ *   sched_switch: prev_comm=a prev_pid=1 prev_prio=120 prev_state=S ==> next_comm=b next_pid=2 next_prio=120
+ *   sched:sched_switch: a:1 [120] S ==> b:2 [120]
+ *   sched_wakeup: comm=b pid=2 prio=120 target_cpu=001
+ *   sched:sched_wakeup: b:2 [120] CPU:001
+ *
+ * preceded by the timestamp in seconds, "1234.567890:". Other lines are
+ * skipped.
+ */
+
+#define TRACE_PID_MAX (1 << 22) // PID_MAX_LIMIT of the kernel
+
+enum trace_kind_t
+{
+	TRACE_SWITCH,
+	TRACE_WAKEUP
+};
+
+/* one event of the trace */
+struct trace_event_t
+{
+	uint8_t kind;
+	uint64_t ns; // timestamp
+	int32_t pid; // woken, or switched out
+	int32_t prio; // of pid, as the kernel has it: 0-99 real time, 100-139 normal
+	char state; // first letter of the state pid is switched out in
+	int32_t next_pid; // switched in
+	int32_t next_prio;
+};
+
+/* \retrun the value after key in s, key being at the start of a word, or NULL */
+inline const char *trace_field(const char *s, const char *key)
+{
+	size_t len = strlen(key);
+	for (const char *p=strstr(s, key); p; p=strstr(p+1, key))
+		if (p == s || p[-1] == ' ')
+			return p + len;
+	return NULL;
+}
+
+/* reads "comm:pid [prio]" of the short format, comm running up to the
+ * last ':' before the " ["
+ * \retrun the end of what was read, or NULL
+ */
+inline const char *trace_task(const char *s, int32_t& pid, int32_t& prio)
+{
+	const char *bracket = strstr(s, " [");
+	const char *colon = bracket;
+
+	if (!bracket)
+		return NULL;
+	while (colon != s && *colon != ':')
+		colon--;
+	if (*colon != ':')
+		return NULL;
+	pid = (int32_t) strtol(colon+1, NULL, 10);
+	prio = (int32_t) strtol(bracket+2, NULL, 10);
+	return strchr(bracket, ']');
+}
+
+/* \retrun the timestamp in s[0..end), the last "<secs>.<fraction>:" in it, in ns */
+inline bool trace_timestamp(const char *s, const char *end, uint64_t& ns)
+{
+	bool found = false;
+
+	for (const char *dot=s; dot!=end; dot++)
+	{
+		if (*dot != '.' || dot == s || !isdigit((unsigned char) dot[-1]))
+			continue;
+
+		const char *p = dot + 1;
+		uint64_t frac = 0, scale = 1000000000ULL;
+		while (p != end && isdigit((unsigned char) *p))
+		{
+			if (scale != 1)
+			{
+				scale /= 10;
+				frac += (uint64_t) (*p - '0') * scale;
+			}
+			p++;
+		}
+		if (p == dot+1 || p == end || *p != ':')
+			continue;
+
+		const char *q = dot;
+		while (q != s && isdigit((unsigned char) q[-1]))
+			q--;
+		ns = strtoull(q, NULL, 10) * 1000000000ULL + frac;
+		found = true;
+	}
+	return found;
+}
+
+/*******************************************************************/
+/*! This function reads one line of a trace.
+		\param line is the line, without its '\n'
+		\param e is set to the event on it
+		\retrun false if the line is not a sched_switch or sched_wakeup
+						event
+*/
+/*******************************************************************/
+inline bool parse_trace_line(const char *line, trace_event_t& e)
+{
+	const char *ev = strstr(line, "sched_switch: ");
+	const char *rest;
+
+	if (ev)
+	{
+		e.kind = TRACE_SWITCH;
+		rest = ev + strlen("sched_switch: ");
+	}
+	else
+	{
+		ev = strstr(line, "sched_wakeup: ");
+		if (!ev)
+			ev = strstr(line, "sched_wakeup_new: ");
+		if (!ev)
+			return false;
+		e.kind = TRACE_WAKEUP;
+		rest = strchr(ev, ' ') + 1;
+	}
+	if (!trace_timestamp(line, ev, e.ns))
+		return false;
+
+	if (e.kind == TRACE_WAKEUP)
+	{
+		const char *pid = trace_field(rest, "pid=");
+		if (pid)
+		{
+			const char *prio = trace_field(rest, "prio=");
+			e.pid = (int32_t) strtol(pid, NULL, 10);
+			e.prio = prio? (int32_t) strtol(prio, NULL, 10): 120;
+			return true;
+		}
+		return trace_task(rest, e.pid, e.prio) != NULL;
+	}
+
+	const char *pid = trace_field(rest, "prev_pid=");
+	if (pid)
+	{
+		const char *prio = trace_field(rest, "prev_prio=");
+		const char *state = trace_field(rest, "prev_state=");
+		const char *next_pid = trace_field(rest, "next_pid=");
+		const char *next_prio = trace_field(rest, "next_prio=");
+		if (!prio || !state || !next_pid || !next_prio)
+			return false;
+		e.pid = (int32_t) strtol(pid, NULL, 10);
+		e.prio = (int32_t) strtol(prio, NULL, 10);
+		e.state = *state;
+		e.next_pid = (int32_t) strtol(next_pid, NULL, 10);
+		e.next_prio = (int32_t) strtol(next_prio, NULL, 10);
+		return true;
+	}
+
+	const char *arrow = strstr(rest, " ==> ");
+	const char *end = trace_task(rest, e.pid, e.prio);
+	if (!arrow || !end || end > arrow || !trace_task(arrow + 5, e.next_pid, e.next_prio))
+		return false;
+	do
+		end++;
+	while (*end == ' ');
+	e.state = *end;
+	return true;
+}
+
+/* Builds the processes of a trace from its events, in the order they
+ * come. A task which exits (state X or Z) and whose pid comes back is
+ * a new process with the same pid. Tasks which never ran are left out.
+ */
+class trace_importer
+{
+private:
+	enum task_state_t
+	{
+		TASK_READY,
+		TASK_RUNNING,
+		TASK_BLOCKED,
+		TASK_DEAD
+	};
+
+	struct task_t
+	{
+		int32_t pid;
+		int32_t prio;
+		uint8_t state;
+		uint8_t ran; // got the cpu in the current cpu phase
+		uint64_t arr; // ns of the first event of the task
+		uint64_t last; // ns of its last event
+		uint64_t since; // ns it got the cpu, or blocked
+		uint64_t cpu; // ns run in the current cpu phase
+		std::vector<int32_t> phases; // in ticks
+	};
+
+	std::vector<task_t> tasks; // in the order they came
+	std::vector<uint32_t> live; // by pid, 1 + its task if not yet dead, else 0
+	uint64_t tick_ns;
+	uint64_t first_ns, last_ns;
+
+	int32_t ticks(uint64_t ns) const
+	{
+		uint64_t t = (ns + tick_ns/2) / tick_ns;
+		return t == 0? 1: t > INT32_MAX? INT32_MAX: (int32_t) t;
+	}
+
+	/* the task of pid, a new one seen first at ns in state if none */
+	task_t& task(int32_t pid, int32_t prio, uint64_t ns, task_state_t state)
+	{
+		if ((size_t) pid >= live.size())
+			live.resize(pid + 1);
+		if (live[pid] == 0)
+		{
+			task_t t = task_t();
+			t.pid = pid;
+			t.state = state;
+			t.arr = t.since = ns;
+			tasks.push_back(t);
+			live[pid] = (uint32_t) tasks.size();
+		}
+
+		task_t& t = tasks[live[pid] - 1];
+		t.prio = prio;
+		t.last = ns;
+		return t;
+	}
+
+	/* closes the cpu phase of t. If it did not run since its last io,
+	 * that io is dropped: a process ends with cpu
+	 */
+	void end_phase(task_t& t)
+	{
+		if (t.ran)
+			t.phases.push_back(ticks(t.cpu));
+		else if (t.phases.size() % 2 == 0 && !t.phases.empty())
+			t.phases.pop_back();
+		t.cpu = 0;
+		t.ran = 0;
+	}
+
+	/* t, blocked, is woken at ns. Sleeps before it first ran are not io */
+	void wake(task_t& t, uint64_t ns)
+	{
+		if (t.phases.size() % 2 == 1)
+			t.phases.push_back(ticks(ns - t.since));
+		t.state = TASK_READY;
+	}
+
+	/* 0-99 real time goes to the kernel priorities, 100-139 to the user
+	 * ones. The kernel's is better when lower, the simulator's when higher
+	 */
+	static int pri_of(int32_t prio)
+	{
+		if (prio < 0)
+			prio = 0;
+		if (prio < 100)
+			return 99 - prio/2;
+		if (prio > 139)
+			prio = 139;
+		return 49 - (prio - 100) * 49 / 39;
+	}
+
+public:
+	uint64_t events; // used
+	uint64_t skipped; // lines which are not events, or events of pids out of range
+
+	/* \param tick_ns is how many ns of the trace one tick of the simulator is */
+	trace_importer(uint64_t tick_ns)
+	{
+		this->tick_ns = tick_ns;
+		first_ns = last_ns = 0;
+		events = skipped = 0;
+	}
+
+	/* e is skipped if its pids cannot be */
+	void add(const trace_event_t& e)
+	{
+		if (e.pid < 0 || e.pid >= TRACE_PID_MAX || (e.kind == TRACE_SWITCH &&
+				(e.next_pid < 0 || e.next_pid >= TRACE_PID_MAX)))
+		{
+			skipped++;
+			return;
+		}
+
+		if (events++ == 0)
+			first_ns = e.ns;
+		last_ns = e.ns;
+
+		if (e.kind == TRACE_WAKEUP)
+		{
+			if (e.pid == 0)
+				return;
+			task_t& t = task(e.pid, e.prio, e.ns, TASK_READY);
+			if (t.state == TASK_BLOCKED)
+				wake(t, e.ns);
+			return;
+		}
+
+		if (e.pid != 0)
+		{
+			/* running since the start of the trace if not seen yet */
+			task_t& t = task(e.pid, e.prio, first_ns, TASK_RUNNING);
+			t.last = e.ns;
+			if (t.state == TASK_RUNNING)
+			{
+				t.cpu += e.ns - t.since;
+				t.ran = 1;
+			}
+
+			if (e.state == 'R')
+				t.state = TASK_READY;
+			else if (e.state == 'X' || e.state == 'Z')
+			{
+				end_phase(t);
+				t.state = TASK_DEAD;
+				live[e.pid] = 0;
+			}
+			else
+			{
+				end_phase(t);
+				t.state = TASK_BLOCKED;
+				t.since = e.ns;
+			}
+		}
+
+		if (e.next_pid != 0)
+		{
+			task_t& t = task(e.next_pid, e.next_prio, e.ns, TASK_READY);
+			if (t.state == TASK_BLOCKED) // its wakeup is not in the trace
+				wake(t, e.ns);
+			t.state = TASK_RUNNING;
+			t.since = e.ns;
+		}
+	}
+
+	/* ends the tasks still alive at the end of the trace */
+	void finish()
+	{
+		for (uint32_t l : live)
+		{
+			if (l == 0)
+				continue;
+			task_t& t = tasks[l - 1];
+			if (t.state == TASK_RUNNING)
+			{
+				t.cpu += last_ns - t.since;
+				t.ran = 1;
+			}
+			end_phase(t);
+		}
+		live.clear();
+	}
+
+	/*******************************************************************/
+	/*! This function writes the processes as a process file. A process
+			arrives the tick the task was first seen, and its deadline is the
+			tick it was last seen: a schedule meets it if it does as well as
+			the kernel did.
+			\param fp is the file
+			\retrun the number of processes written
+	*/
+	/*******************************************************************/
+	size_t write(FILE *fp) const
+	{
+		size_t n = 0;
+
+		fprintf(fp, "Pid\tBst\tArr\tPri\tDline\tIO\tDev\tPos\tPhases\n");
+		for (const task_t& t : tasks)
+		{
+			int64_t bst = 0;
+			for (size_t i=0; i<t.phases.size(); i+=2)
+				bst += t.phases[i];
+			if (t.phases.empty() || bst > INT32_MAX || t.pid <= 0)
+				continue;
+
+			int64_t arr = (int64_t) ((t.arr - first_ns) / tick_ns);
+			int64_t dline = arr + ticks(t.last - t.arr);
+			if (dline < arr + bst)
+				dline = arr + bst;
+			if (dline > INT32_MAX)
+				continue;
+
+			fprintf(fp, "%d\t%lld\t%lld\t%d\t%lld\t0\t0\t0\t", t.pid, (long long) bst,
+							(long long) arr, pri_of(t.prio), (long long) dline);
+			for (size_t i=0; i!=t.phases.size(); i++)
+				fprintf(fp, i? ",%d": "%d", t.phases[i]);
+			fputc('\n', fp);
+			n++;
+		}
+		return n;
+	}
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Column kernels used when loading the process file and when reducing
+ * the process table into statistics. Each works on 4 lanes at a time
+ * with SSE2 (always available on x86-64) and finishes the remainder, or
+ * everything on other targets, with the equivalent scalar loop.
+ */
+
+/* validity of one process, as read from the file */
+#define VALID(pid, bst, arr, pri, dline, io) \
+	(pid>0 && bst>0 && arr>=0 && pri>=0 && pri<=99 && dline>0 && io>=0)
+
+/*******************************************************************/
+/*! Writes valid[i] = 1 if row i of the columns is a valid process.
+		\retrun the number of valid rows
+*/
+/*******************************************************************/
+inline size_t validate_columns(const int32_t *pid, const int32_t *bst, const int32_t *arr,
+															 const int32_t *pri, const int32_t *dline, const int32_t *io,
+															 uint8_t *valid, size_t n)
+{
+	size_t i = 0, nvalid = 0;
+
+#ifdef __SSE2__
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i minus_one = _mm_set1_epi32(-1);
+	const __m128i pri_max = _mm_set1_epi32(100);
+
+	for (; i+4 <= n; i+=4)
+	{
+		__m128i ok = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*) (pid+i)), zero);
+		ok = _mm_and_si128(ok, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*) (bst+i)), zero));
+		ok = _mm_and_si128(ok, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*) (arr+i)), minus_one));
+		__m128i p = _mm_loadu_si128((const __m128i*) (pri+i));
+		ok = _mm_and_si128(ok, _mm_cmpgt_epi32(p, minus_one));
+		ok = _mm_and_si128(ok, _mm_cmplt_epi32(p, pri_max));
+		ok = _mm_and_si128(ok, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*) (dline+i)), zero));
+		ok = _mm_and_si128(ok, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*) (io+i)), minus_one));
+
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(ok));
+		valid[i] = mask & 1;
+		valid[i+1] = (mask >> 1) & 1;
+		valid[i+2] = (mask >> 2) & 1;
+		valid[i+3] = (mask >> 3) & 1;
+		nvalid += __builtin_popcount(mask);
+	}
+#endif
+
+	for (; i != n; i++)
+	{
+		valid[i] = VALID(pid[i], bst[i], arr[i], pri[i], dline[i], io[i]);
+		nvalid += valid[i];
+	}
+
+	return nvalid;
+}
+
+/*******************************************************************/
+/*! \retrun the sum of a column of 32-bit integers, widened to 64 bits */
+/*******************************************************************/
+inline int64_t sum_column(const int32_t *a, size_t n)
+{
+	size_t i = 0;
+	int64_t sum = 0;
+
+#ifdef __SSE2__
+	__m128i acc = _mm_setzero_si128();
+	for (; i+4 <= n; i+=4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*) (a+i));
+		__m128i sign = _mm_srai_epi32(v, 31);
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+	}
+
+	int64_t lanes[2];
+	_mm_storeu_si128((__m128i*) lanes, acc);
+	sum = lanes[0] + lanes[1];
+#endif
+
+	for (; i != n; i++)
+		sum += a[i];
+	return sum;
+}
+
+/*******************************************************************/
+/*! \retrun the sum of a column of 64-bit integers */
+/*******************************************************************/
+inline uint64_t sum_column(const uint64_t *a, size_t n)
+{
+	size_t i = 0;
+	uint64_t sum = 0;
+
+#ifdef __SSE2__
+	__m128i acc = _mm_setzero_si128();
+	for (; i+2 <= n; i+=2)
+		acc = _mm_add_epi64(acc, _mm_loadu_si128((const __m128i*) (a+i)));
+
+	uint64_t lanes[2];
+	_mm_storeu_si128((__m128i*) lanes, acc);
+	sum = lanes[0] + lanes[1];
+#endif
+
+	for (; i != n; i++)
+		sum += a[i];
+	return sum;
+}
+
+#endif
@@ -0,0 +1,2109 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "gantt_writer.h"
+#include "metrics.h"
+#include "observers.h"
+#include "proc_queues.h"
+#include "sched_policy.h"
+#include "simd.h"
+#include "simulator.h"
+
+/*************************************************
+ ******************** TYPES **********************
+ ************************************************/
+/* used by promote_priority */
+enum ops_t
+{
+	IO,
+	AGE
+};
+
+/* the window of processes shown in interactive mode: rows of them,
+ * in pid order, starting with the first-th.
+ */
+struct view_t
+{
+	enum { DEFAULT_ROWS = 10 };
+
+	size_t first;
+	size_t rows;
+	size_t stop_at; // nothing is shown before this clock
+	std::vector<pidx_t> by_pid; // every process, ordered by pid
+
+	view_t()
+	{
+		first = 0;
+		rows = DEFAULT_ROWS;
+		stop_at = 0;
+	}
+
+	void build(const proc_table_t& tbl)
+	{
+		if (by_pid.size() == tbl.size())
+			return;
+
+		by_pid.resize(tbl.size());
+		for (size_t i=0; i!=by_pid.size(); i++)
+			by_pid[i] = (pidx_t) i;
+		std::stable_sort(by_pid.begin(), by_pid.end(),
+										 [&tbl](pidx_t lhs, pidx_t rhs) { return tbl.pid[lhs] < tbl.pid[rhs]; });
+	}
+};
+
+
+/* the options of a run, and what it writes to */
+struct env_t : sim_config_t
+{
+	std::ofstream outfs;
+	gantt_writer gantt; // writes outfs while the scheduler runs
+	proc_metrics_t metrics;
+	view_t view; // interactive mode
+	std::vector<event_handler_t> handlers; // see Simulator::subscribe
+
+	/* copy the options, not the output, for a branch of a what-if run */
+	void copy_options(const sim_config_t& o)
+	{
+		static_cast<sim_config_t&>(*this) = o;
+	}
+
+	/* is a Gantt chart written? */
+	bool charting() const
+	{
+		return !output_name.empty();
+	}
+
+	/* is anything written, shown or handed out as the run goes? If not,
+	 * it is run without observers.
+	 */
+	bool observed() const
+	{
+		return charting() || interactive || !metrics_name.empty() || !handlers.empty();
+	}
+
+	/* an event of the Gantt chart, written if there is one */
+	void event(size_t Clock, int32_t pid, gantt_action_t action)
+	{
+		if (charting())
+			gantt.push(Clock, pid, action);
+	}
+};
+
+/* Everything run_scheduler carries from one clock tick to the next,
+ * other than the queues. This is what a checkpoint saves.
+ */
+struct run_state_t
+{
+	size_t Clock; // the next tick to run
+	bool running; // is there a process running?
+	pidx_t x; // the running process if running=true
+	int tq, org_tq; // ticks run and time quantum of x
+	pidx_t last; // the last process to get the cpu, NO_PROC if none
+	int overhead; // ticks left before x runs, for the context switch
+	io_t io_q;
+	bandwidth_t bw; // cpu quotas
+	dvfs_t dvfs; // cpu frequency
+	std::vector<size_t> wait; // used only by edf scheduler
+
+	run_state_t()
+	{
+		Clock = 0;
+		running = false;
+		x = 0;
+		tq = org_tq = 0;
+		last = NO_PROC;
+		overhead = 0;
+	}
+};
+
+/* a run of the scheduler, whatever its policy, see engine_t */
+class engine_base
+{
+public:
+	virtual ~engine_base()
+	{
+	}
+
+	/* runs a clock tick.
+	 * \retrun false once the run is over, or forked into its branches
+	 */
+	virtual bool step() = 0;
+
+	virtual bool forked() const = 0;
+
+	/* the next tick to run */
+	virtual size_t clock() const = 0;
+};
+
+/**************************************************
+ ********************* MACROS *********************
+ *************************************************/
+
+#define ISMAXED(x) (x==49 || x==99)
+#define ISKERNEL(x) (x>=50 && x<=99)
+
+#define GETS_CPU gantt_action_text[GANTT_GETS_CPU]
+#define END gantt_action_text[GANTT_END]
+#define TQ_INTER gantt_action_text[GANTT_TQ_INTER]
+#define IO_INTER gantt_action_text[GANTT_IO_INTER]
+#define THROTTLED gantt_action_text[GANTT_THROTTLED]
+#define AGED "Has Aged"
+#define ABORT "Cannot Meet Deadline"
+
+#define PRINT_STATE(env, Clock, pid, state) ((env).event(Clock, pid, GANTT_##state))
+#define PRINT_STATE_INTER(os, Clock, pid, state) (os << "process " << (pid) << " \'" << state << "\'" << std::endl)
+#define SHOWING(env, Clock) (env.interactive && Clock >= env.view.stop_at)
+#define VIEW_HELP \
+	"Commands, then <enter> on an empty line to carry on:\n" \
+	"  c <clock>\trun until <clock> without stopping\n" \
+	"  p <pid>\tshow the processes from <pid> on\n" \
+	"  n, b\t\tnext, previous page of processes\n" \
+	"  r <rows>\tprocesses per page\n" \
+	"  q\t\trun to the end without stopping\n"
+
+/**************************************************
+ ******************* OBSERVERS ********************
+ *************************************************/
+
+/* writes the Gantt chart */
+struct chart_observer_t : null_observer_t
+{
+	env_t& env;
+	const proc_table_t& tbl;
+
+	chart_observer_t(env_t& env, const proc_table_t& tbl)
+		: env(env), tbl(tbl)
+	{
+	}
+
+	void dispatch(size_t Clock, pidx_t x)
+	{
+		PRINT_STATE(env, Clock, tbl.pid[x], GETS_CPU);
+	}
+
+	void preempt(size_t Clock, pidx_t x)
+	{
+		PRINT_STATE(env, Clock, tbl.pid[x], TQ_INTER);
+	}
+
+	void throttle(size_t Clock, pidx_t x)
+	{
+		PRINT_STATE(env, Clock, tbl.pid[x], THROTTLED);
+	}
+
+	void io_start(size_t Clock, pidx_t x)
+	{
+		PRINT_STATE(env, Clock, tbl.pid[x], IO_INTER);
+	}
+
+	void completion(size_t Clock, pidx_t x)
+	{
+		PRINT_STATE(env, Clock, tbl.pid[x], END);
+	}
+};
+
+/* prints the events while the interactive view is shown */
+struct view_observer_t : null_observer_t
+{
+	env_t& env;
+	const proc_table_t& tbl;
+
+	view_observer_t(env_t& env, const proc_table_t& tbl)
+		: env(env), tbl(tbl)
+	{
+	}
+
+	bool wants_aging(size_t Clock) const
+	{
+		return SHOWING(env, Clock);
+	}
+
+	void aging(size_t Clock, pidx_t x)
+	{
+		if (SHOWING(env, Clock))
+			PRINT_STATE_INTER(std::cout, Clock, tbl.pid[x], AGED);
+	}
+
+	void dispatch(size_t Clock, pidx_t x)
+	{
+		if (SHOWING(env, Clock))
+			PRINT_STATE_INTER(std::cout, Clock, tbl.pid[x], GETS_CPU);
+	}
+
+	void preempt(size_t Clock, pidx_t x)
+	{
+		if (SHOWING(env, Clock))
+			PRINT_STATE_INTER(std::cout, Clock, tbl.pid[x], TQ_INTER);
+	}
+
+	void throttle(size_t Clock, pidx_t x)
+	{
+		if (SHOWING(env, Clock))
+			PRINT_STATE_INTER(std::cout, Clock, tbl.pid[x], THROTTLED);
+	}
+
+	void io_start(size_t Clock, pidx_t x)
+	{
+		if (SHOWING(env, Clock))
+			PRINT_STATE_INTER(std::cout, Clock, tbl.pid[x], IO_INTER);
+	}
+
+	void abort(size_t Clock, pidx_t x)
+	{
+		if (SHOWING(env, Clock))
+			PRINT_STATE_INTER(std::cout, Clock, tbl.pid[x], ABORT);
+	}
+
+	void completion(size_t Clock, pidx_t x)
+	{
+		if (SHOWING(env, Clock))
+			PRINT_STATE_INTER(std::cout, Clock, tbl.pid[x], END);
+	}
+};
+
+/* records the per-process metrics of each process as it terminates */
+struct metrics_observer_t : null_observer_t
+{
+	env_t& env;
+	const proc_table_t& tbl;
+
+	metrics_observer_t(env_t& env, const proc_table_t& tbl)
+		: env(env), tbl(tbl)
+	{
+	}
+
+	void completion(size_t, pidx_t x)
+	{
+		if (!env.metrics_name.empty())
+			env.metrics.record(tbl, x);
+	}
+};
+
+/* hands every event to the handlers of Simulator::subscribe */
+struct handler_observer_t
+{
+	env_t& env;
+	const proc_table_t& tbl;
+
+	handler_observer_t(env_t& env, const proc_table_t& tbl)
+		: env(env), tbl(tbl)
+	{
+	}
+
+	bool wants_aging(size_t) const
+	{
+		return !env.handlers.empty();
+	}
+
+	void arrival(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_ARRIVAL);
+	}
+
+	void aging(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_AGING);
+	}
+
+	void dispatch(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_DISPATCH);
+	}
+
+	void preempt(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_PREEMPT);
+	}
+
+	void throttle(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_THROTTLE);
+	}
+
+	void io_start(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_IO_START);
+	}
+
+	void io_end(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_IO_END);
+	}
+
+	void abort(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_ABORT);
+	}
+
+	void completion(size_t Clock, pidx_t x)
+	{
+		hand(Clock, x, SIM_COMPLETION);
+	}
+
+	void hand(size_t Clock, pidx_t x, sim_event_kind_t kind)
+	{
+		if (env.handlers.empty())
+			return;
+
+		sim_event_t e;
+		e.Clock = Clock;
+		e.pid = tbl.pid[x];
+		e.kind = kind;
+		for (auto& handler : env.handlers)
+			handler(e);
+	}
+};
+
+/* the observer of a run with output or handlers: each of the above,
+ * each doing nothing unless env asks for it
+ */
+typedef observer_pair_t<chart_observer_t, observer_pair_t<handler_observer_t, 
+	observer_pair_t<view_observer_t, metrics_observer_t> > > env_observer_t;
+
+/* \retrun the observer of a run writing the output of env */
+inline env_observer_t watch(env_t& env, const proc_table_t& tbl)
+{
+	typedef observer_pair_t<view_observer_t, metrics_observer_t> shown_t;
+	typedef observer_pair_t<handler_observer_t, shown_t> handed_t;
+
+	return env_observer_t(chart_observer_t(env, tbl), 
+												handed_t(handler_observer_t(env, tbl), shown_t(view_observer_t(env, tbl), metrics_observer_t(env, tbl))));
+}
+
+/**************************************************
+ ************* FUNCTOIN PROTOTYPES **************
+ **************************************************/
+
+template<typename P, typename O>
+engine_base *make_grouped(proc_table_t&, new_t&, env_t&, stats_t&, std::vector<stats_t>&, const O&);
+
+template<typename O>
+engine_base *make_policy(proc_table_t&, new_t&, env_t&, stats_t&, std::vector<stats_t>&, const O&);
+
+engine_base *make_engine(proc_table_t&, new_t&, env_t&, stats_t&, std::vector<stats_t>&);
+
+template<typename P>
+void run_branches(proc_table_t&, new_t&, typename P::ready_t&, run_state_t&, stats_t&, std::vector<stats_t>&, env_t&);
+
+template<typename Q, typename P>
+void run_branch(const proc_table_t&, const new_t&, const typename P::ready_t&, const run_state_t&, stats_t&, env_t&);
+
+template<typename R, typename O>
+void update(proc_table_t&, new_t&, R&, size_t Clock, size_t, O&);
+
+template<typename R, typename O>
+void do_io(proc_table_t&, R&, io_t&, env_t&, size_t, O&);
+
+template<typename R>
+void do_refresh(R&, bandwidth_t&, size_t);
+
+template<typename T, typename O>
+void do_aging(proc_table_t&, ready_age_t<T>&, env_t&, size_t, O&);
+
+template<typename O>
+void do_aging(proc_table_t&, lazy_ready_t&, env_t&, size_t, O&);
+
+template<typename R, typename O>
+void do_aging(proc_table_t&, group_ready_t<R>&, env_t&, size_t, O&);
+
+template<typename P>
+void print_states(proc_table_t&, new_t&, typename P::ready_t&, io_t&, pidx_t, bool, int, env_t&, size_t);
+
+bool view_command(proc_table_t&, const std::string&, env_t&);
+
+template<typename P, typename O>
+bool run_scheduler(proc_table_t&, new_t&, typename P::ready_t&, env_t&, stats_t&, run_state_t&, O&);
+
+template<typename P>
+bool start_run(proc_table_t&, new_t&, typename P::ready_t&, env_t&, stats_t&, run_state_t&);
+
+template<typename P>
+bool more_to_run(new_t&, typename P::ready_t&, run_state_t&);
+
+template<typename P, typename O>
+void run_tick(proc_table_t&, new_t&, typename P::ready_t&, env_t&, stats_t&, run_state_t&, O&);
+
+template<typename P>
+void end_run(env_t&, stats_t&, run_state_t&);
+
+template<typename R>
+void save_checkpoint(proc_table_t&, new_t&, R&, run_state_t&, stats_t&, env_t&);
+
+template<typename R>
+void load_checkpoint(proc_table_t&, new_t&, R&, run_state_t&, stats_t&, env_t&);
+
+uint64_t fingerprint(proc_table_t&, env_t&);
+
+void stop_gantt(env_t&);
+
+void save_metrics(env_t&);
+
+inline int switch_overhead(const proc_table_t&, pidx_t, const run_state_t&, const env_t&);
+
+inline void demote_priority(proc_table_t&, pidx_t, env_t&);
+
+inline void promote_priority(proc_table_t&, pidx_t, ops_t, env_t&);
+
+
+/* A run of the scheduler described by the policy P, a tick at a time:
+ * run_scheduler taken apart, so the loop is the caller's. The first step
+ * starts the run, and the one after the last tick ends it, or hands the
+ * state to the branches at the fork clock. The events of the run go to
+ * the observer O, see observers.h.
+ */
+template<typename P, typename O>
+class engine_t : public engine_base
+{
+private:
+	enum phase_t
+	{
+		NEW,
+		RUNNING,
+		FORKED,
+		DONE
+	};
+
+	proc_table_t& tbl;
+	new_t& new_q;
+	env_t& env;
+	stats_t& stats;
+	std::vector<stats_t>& branch_stats;
+	typename P::ready_t ready_age_q;
+	run_state_t st;
+	O obs;
+	phase_t phase;
+
+public:
+	engine_t(proc_table_t& tbl, new_t& new_q, env_t& env, stats_t& stats, std::vector<stats_t>& branch_stats,
+					 const O& obs)
+		: tbl(tbl), new_q(new_q), env(env), stats(stats), branch_stats(branch_stats),
+			ready_age_q(tbl, P::AGING? env.age_time: 0, env.age_val), obs(obs), phase(NEW)
+	{
+		st.io_q.configure(env.io_devices, env.io_discipline);
+		st.bw.configure(tbl, env.cpu_quotas, [&tbl](pidx_t x) { return ISKERNEL(tbl.base_pri[x]); });
+		st.dvfs.configure(env.governor, env.cpu_levels, env.governor_sample, tbl.size());
+	}
+
+	bool step()
+	{
+		if (phase == NEW)
+		{
+			phase = RUNNING;
+			if (!start_run<P>(tbl, new_q, ready_age_q, env, stats, st))
+			{
+				stats.reduce(tbl, !P::DEADLINES);
+				phase = DONE;
+			}
+		}
+		if (phase != RUNNING)
+			return false;
+
+		if (!more_to_run<P>(new_q, ready_age_q, st))
+		{
+			end_run<P>(env, stats, st);
+			stats.reduce(tbl, !P::DEADLINES);
+			phase = DONE;
+			return false;
+		}
+
+		/* stop here and let the branches carry on */
+		if (st.Clock == env.fork_at)
+		{
+			stop_gantt(env);
+			run_branches<P>(tbl, new_q, ready_age_q, st, stats, branch_stats, env);
+			phase = FORKED;
+			return false;
+		}
+
+		run_tick<P>(tbl, new_q, ready_age_q, env, stats, st, obs);
+		return true;
+	}
+
+	bool forked() const
+	{
+		return phase == FORKED;
+	}
+
+	size_t clock() const
+	{
+		return st.Clock;
+	}
+};
+
+/* what a Simulator runs */
+struct Simulator::impl_t
+{
+	env_t env;
+	proc_table_t tbl;
+	new_t new_q;
+	stats_t stats;
+	std::vector<stats_t> branch_stats;
+	std::unique_ptr<engine_base> engine;
+	std::string error;
+	bool loaded;
+	bool averaged; // have the stats of the run been averaged?
+
+	impl_t()
+	{
+		loaded = averaged = false;
+	}
+
+	/* \retrun the engine of the run, made on the first step with the
+	 * handlers subscribed by then; NULL if nothing was loaded
+	 */
+	engine_base *get()
+	{
+		if (!engine && loaded)
+			engine.reset(make_engine(tbl, new_q, env, stats, branch_stats));
+		return engine.get();
+	}
+
+	/* averages the stats of a run which is over */
+	void average()
+	{
+		if (averaged || engine->forked())
+			return;
+		averaged = true;
+		stats.att /= (double) stats.np;
+		stats.awt /= (double) stats.np;
+	}
+};
+
+
+/*****************************************************
+ *************** FUNCTION DEFINITIONS ****************
+ ****************************************************/
+Simulator::Simulator()
+	: impl(new impl_t)
+{
+}
+
+
+Simulator::~Simulator()
+{
+}
+
+
+void Simulator::configure(const sim_config_t& config)
+{
+	impl->env.copy_options(config);
+	impl->env.branches = config.branches;
+}
+
+
+/*************************************************************************/
+/*! This functions reads the process file and checks it against the
+		options: every process doing io must have its device, and the groups
+		given shares or quotas must be in the file. The output file is
+		opened; on resume it is cut back by load_checkpoint.
+    \param file_name is the name of the process file
+    \retrun false if the processes cannot be run, with the reason in error
+*/
+/*************************************************************************/
+bool Simulator::load(const std::string& file_name)
+{
+	env_t& env = impl->env;
+	proc_table_t& tbl = impl->tbl;
+
+	/* create_new_queue stops the program on a file it cannot read */
+	if (!std::ifstream(file_name.c_str()).is_open())
+	{
+		impl->error = "Could not read file \'" + file_name + "\'";
+		return false;
+	}
+
+	/* read the input file into the process table and create the new queue */
+	env.file_name = file_name;
+	impl->new_q = create_new_queue(env.file_name, tbl);
+	impl->stats.np = impl->new_q.size();
+
+	/* every process doing io must have its device */
+	if (env.io_devices != 0)
+		for (pidx_t x=0; x!=tbl.size(); x++)
+			if (tbl.does_io(x) && (size_t) tbl.dev[x] >= env.io_devices)
+			{
+				impl->error = "Process " + std::to_string(tbl.pid[x]) + " uses io device " + std::to_string(tbl.dev[x]) +
+					" but there are " + std::to_string(env.io_devices);
+				return false;
+			}
+
+	/* give the groups their shares */
+	for (auto& share : env.group_shares)
+	{
+		uint32_t g = tbl.groups.find(share.first);
+		if (g == NO_GROUP || g == ROOT_GROUP)
+		{
+			impl->error = "There is no group \'" + share.first + "\' in the process file";
+			return false;
+		}
+		tbl.groups.shares[g] = share.second;
+	}
+
+	/* the quotas not of a class are of a group */
+	for (auto& q : env.cpu_quotas)
+	{
+		uint32_t g = tbl.groups.find(q.name);
+		if (q.name == KERNEL_CLASS || q.name == USER_CLASS)
+			tbl.groups.by_class = true;
+		else if (g == NO_GROUP || g == ROOT_GROUP)
+		{
+			impl->error = "There is no group \'" + q.name + "\' in the process file";
+			return false;
+		}
+	}
+
+	/* open the output file. On resume it is cut back by load_checkpoint */
+	if (env.charting() && env.resume)
+		env.outfs.open(env.output_name.c_str(), std::ios::app | std::ios::binary);
+	else if (env.charting())
+		env.outfs.open(env.output_name.c_str(), std::ios::binary);
+
+	impl->loaded = true;
+	return true;
+}
+
+
+bool Simulator::subscribe(const event_handler_t& handler)
+{
+	if (impl->engine)
+		return false;
+	impl->env.handlers.push_back(handler);
+	return true;
+}
+
+
+bool Simulator::step()
+{
+	if (!impl->get())
+		return false;
+	if (impl->engine->step())
+		return true;
+	impl->average();
+	return false;
+}
+
+
+bool Simulator::run()
+{
+	if (!impl->get())
+		return false;
+	while (impl->engine->step())
+		;
+	impl->average();
+	return !impl->engine->forked();
+}
+
+
+size_t Simulator::clock() const
+{
+	return impl->engine? impl->engine->clock(): 0;
+}
+
+
+const stats_t& Simulator::stats() const
+{
+	return impl->stats;
+}
+
+
+const std::vector<stats_t>& Simulator::branch_stats() const
+{
+	return impl->branch_stats;
+}
+
+
+const std::string& Simulator::error() const
+{
+	return impl->error;
+}
+
+
+/*************************************************************************/
+/*! This functions makes the engine of the scheduler given by the user
+		with the policy P, in groups if the process file has any or there
+		are cpu quotas, which the groups' ready queue enforces.
+    \param tbl is the table of all processes
+    \param new_q is the queue of processes organized by arrival time
+    \param env is the struct of user-provided values
+    \param stats is the statistics of the run
+    \param branch_stats is the statistics of each branch, if forked
+    \param obs is the observer of the events of the run
+    \retrun the engine
+*/
+/*************************************************************************/
+template<typename P, typename O>
+engine_base *make_grouped(proc_table_t& tbl, new_t& new_q, env_t& env, stats_t& stats,
+													std::vector<stats_t>& branch_stats, const O& obs)
+{
+	if (tbl.groups.size() > 1 || !env.cpu_quotas.empty())
+		return new engine_t<group_policy<P>, O>(tbl, new_q, env, stats, branch_stats, obs);
+	return new engine_t<P, O>(tbl, new_q, env, stats, branch_stats, obs);
+}
+
+
+/*************************************************************************/
+/*! This functions makes the engine of the scheduler given by the user,
+		with the observer O.
+    \param tbl is the table of all processes
+    \param new_q is the queue of processes organized by arrival time
+    \param env is the struct of user-provided values
+    \param stats is the statistics of the run
+    \param branch_stats is the statistics of each branch, if forked
+    \param obs is the observer of the events of the run
+    \retrun the engine
+*/
+/*************************************************************************/
+template<typename O>
+engine_base *make_policy(proc_table_t& tbl, new_t& new_q, env_t& env, stats_t& stats,
+												 std::vector<stats_t>& branch_stats, const O& obs)
+{
+	if (env.scheduler == FIFO)
+		return make_grouped<fifo_policy>(tbl, new_q, env, stats, branch_stats, obs);
+	else if (env.scheduler == PRIORITY && env.lazy_aging)
+		return make_grouped<lazy_priority_policy>(tbl, new_q, env, stats, branch_stats, obs);
+	else if (env.scheduler == SJF)
+		return make_grouped<sjf_policy>(tbl, new_q, env, stats, branch_stats, obs);
+	else if (env.scheduler == EDF)
+		return make_grouped<edf_policy>(tbl, new_q, env, stats, branch_stats, obs);
+	return make_grouped<priority_policy>(tbl, new_q, env, stats, branch_stats, obs);
+}
+
+
+/*************************************************************************/
+/*! This functions makes the engine of the scheduler given by the user.
+		A run nothing observes, with no output and no handlers, is run with
+		null_observer_t, so it does nothing but schedule.
+    \param tbl is the table of all processes
+    \param new_q is the queue of processes organized by arrival time
+    \param env is the struct of user-provided values
+    \param stats is the statistics of the run
+    \param branch_stats is the statistics of each branch, if forked
+    \retrun the engine
+*/
+/*************************************************************************/
+engine_base *make_engine(proc_table_t& tbl, new_t& new_q, env_t& env, stats_t& stats,
+												 std::vector<stats_t>& branch_stats)
+{
+	if (env.observed())
+		return make_policy(tbl, new_q, env, stats, branch_stats, watch(env, tbl));
+	return make_policy(tbl, new_q, env, stats, branch_stats, null_observer_t());
+}
+
+
+/*************************************************************************/
+/*! This functions runs every branch of a what-if run in its own thread,
+		each from a copy of the state at the fork clock, and averages their
+		stats, in the order the branches were given.
+    \param tbl is the table of all processes at the fork clock
+    \param new_q is the queue of processes organized by arrival time
+    \param ready_age_q is the ready queue of the scheduler before the fork
+    \param st is the rest of the state at the fork clock
+    \param stats is the statistics up to the fork clock
+    \param branch_stats is written with the statistics of each branch
+    \param env is the struct of user-provided values
+*/
+/*************************************************************************/    
+template<typename P>
+void run_branches(proc_table_t& tbl, new_t& new_q, typename P::ready_t& ready_age_q, 
+									run_state_t& st, stats_t& stats, std::vector<stats_t>& branch_stats, env_t& env)
+{
+	size_t n = env.branches.size();
+	std::vector<env_t> envs(n);
+	std::vector<std::thread> threads;
+
+	branch_stats.assign(n, stats);
+
+	/* the branches copy the table, so it must be up to date */
+	ready_age_q.sync();
+
+	for (size_t i=0; i!=n; i++)
+	{
+		branch_t& b = env.branches[i];
+		env_t& benv = envs[i];
+		stats_t& bstats = branch_stats[i];
+
+		benv.copy_options(env);
+		benv.scheduler = b.scheduler;
+		benv.user_tq = b.user_tq;
+		benv.kernel_tq = b.kernel_tq;
+		benv.interactive = false;
+		benv.resume = false;
+		benv.checkpoint_every = 0;
+		benv.fork_at = NO_FORK;
+		if (env.charting())
+		{
+			benv.output_name = env.output_name;
+			if (env.packed)
+				benv.output_name.erase(benv.output_name.size() - (sizeof(PACKED_EXT) - 1));
+			benv.output_name += "-branch" + std::to_string(i+1) + (env.packed? PACKED_EXT: "");
+			benv.outfs.open(benv.output_name.c_str(), std::ios::binary);
+		}
+		if (!env.metrics_name.empty())
+			benv.metrics_name = env.metrics_name + "-branch" + std::to_string(i+1);
+
+		if (b.scheduler == FIFO)
+			threads.push_back(std::thread(run_branch<typename branch_policy<fifo_policy, P::GROUPS>::type, P>, std::cref(tbl), std::cref(new_q), 
+										std::cref(ready_age_q), std::cref(st), std::ref(bstats), std::ref(benv)));
+		else if (b.scheduler == SJF)
+			threads.push_back(std::thread(run_branch<typename branch_policy<sjf_policy, P::GROUPS>::type, P>, std::cref(tbl), std::cref(new_q), 
+										std::cref(ready_age_q), std::cref(st), std::ref(bstats), std::ref(benv)));
+		else if (b.scheduler == PRIORITY && benv.lazy_aging)
+			threads.push_back(std::thread(run_branch<typename branch_policy<lazy_priority_policy, P::GROUPS>::type, P>, std::cref(tbl), std::cref(new_q), 
+										std::cref(ready_age_q), std::cref(st), std::ref(bstats), std::ref(benv)));
+		else if (b.scheduler == PRIORITY)
+			threads.push_back(std::thread(run_branch<typename branch_policy<priority_policy, P::GROUPS>::type, P>, std::cref(tbl), std::cref(new_q), 
+										std::cref(ready_age_q), std::cref(st), std::ref(bstats), std::ref(benv)));
+		else if (b.scheduler == EDF)
+			threads.push_back(std::thread(run_branch<typename branch_policy<edf_policy, P::GROUPS>::type, P>, std::cref(tbl), std::cref(new_q), 
+										std::cref(ready_age_q), std::cref(st), std::ref(bstats), std::ref(benv)));
+	}
+
+	for (auto& t : threads)
+		t.join();
+
+	for (size_t i=0; i!=n; i++)
+	{
+		stats_t& bstats = branch_stats[i];
+		bstats.att /= (double) bstats.np;
+		bstats.awt /= (double) bstats.np;
+		envs[i].outfs.close();
+	}
+}
+
+
+/*************************************************************************/
+/*! This functions continues a forked run with the policy Q from the
+		state of a run with the policy P. The trunk is only read, so all the
+		branches share it.
+    \param tbl is the table of all processes at the fork clock
+    \param new_q is the queue of processes organized by arrival time
+    \param trunk is the ready queue of the scheduler before the fork
+    \param st is the rest of the state at the fork clock
+    \param stats is the statistics of this branch
+    \param env is the struct of values for this branch
+*/
+/*************************************************************************/    
+template<typename Q, typename P>
+void run_branch(const proc_table_t& tbl, const new_t& new_q, const typename P::ready_t& trunk, 
+								const run_state_t& st, stats_t& stats, env_t& env)
+{
+	proc_table_t branch_tbl(tbl);
+	new_t branch_new_q(new_q);
+	run_state_t branch_st(st);
+	typename Q::ready_t ready_age_q(branch_tbl, Q::AGING? env.age_time: 0, env.age_val);
+
+	branch_st.bw.restore([&ready_age_q](uint32_t g, int kernel, bool on) { ready_age_q.throttle(g, kernel, on); });
+	ready_age_q.assign(trunk);
+	if (!env.metrics_name.empty())
+		env.metrics.rebuild(branch_tbl);
+	if (Q::DEADLINES && !P::DEADLINES)
+		branch_st.wait.assign(branch_tbl.size(), 0);
+	else if (!Q::DEADLINES)
+		branch_st.wait.clear();
+
+	if (branch_st.Clock != 0 && env.charting()) // otherwise run_scheduler starts the file
+		gantt_writer::header(env.outfs, env.packed);
+	env_observer_t obs(watch(env, branch_tbl));
+	run_scheduler<Q>(branch_tbl, branch_new_q, ready_age_q, env, stats, branch_st, obs);
+
+	/* the awt comes from the table, as in a run of Q alone */
+	stats.reduce(branch_tbl, !Q::DEADLINES);
+}
+
+
+/*************************************************************************/
+/*! This functions runs the scheduler described by the policy P
+    \param tbl is the table of all processes
+    \param new_q is the queue of processes organized by arrival time
+    \param ready_age_q is the queue of processes organized by scheduler
+    			 with a corresponding age_q
+    \param env is the struct of user-provided values
+    \param stats is the statistics of the run
+    \param st is the state to start from; Clock=0 for a new run
+    \param obs is the observer of the events of the run
+    \retrun true if every process was run; false if stopped at env.fork_at
+*/
+/*************************************************************************/    
+template<typename P, typename O>
+bool run_scheduler(proc_table_t& tbl, new_t& new_q, typename P::ready_t& ready_age_q, env_t &env, stats_t &stats, run_state_t& st, O& obs)
+{
+	if (!start_run<P>(tbl, new_q, ready_age_q, env, stats, st))
+		return true;
+
+	/* each iteration is a clock tick */
+	while (more_to_run<P>(new_q, ready_age_q, st))
+	{
+		/* stop here and let the branches carry on */
+		if (st.Clock == env.fork_at)
+		{
+			stop_gantt(env);
+			return false;
+		}
+		run_tick<P>(tbl, new_q, ready_age_q, env, stats, st, obs);
+	}
+
+	end_run<P>(env, stats, st);
+	return true;
+}
+
+
+/*************************************************************************/
+/*! This functions starts a run of the scheduler described by the policy
+		P, from a checkpoint if resuming, and starts the Gantt chart.
+    \param tbl is the table of all processes
+    \param new_q is the queue of processes organized by arrival time
+    \param ready_age_q is the queue of processes organized by scheduler
+    \param env is the struct of user-provided values
+    \param stats is the statistics of the run
+    \param st is the state to start from; Clock=0 for a new run
+    \retrun false if there are no processes to run
+*/
+/*************************************************************************/    
+template<typename P>
+bool start_run(proc_table_t& tbl, new_t& new_q, typename P::ready_t& ready_age_q, env_t &env, stats_t &stats, run_state_t& st)
+{
+	std::vector<size_t>& wait = st.wait;
+	std::string line;
+
+	if (env.resume) /* carry on from where the checkpoint was taken */
+		load_checkpoint(tbl, new_q, ready_age_q, st, stats, env);
+	else if (st.Clock == 0)
+	{
+		/* The first line of the output file are the column titles */
+		if (env.charting())
+			gantt_writer::header(env.outfs, env.packed);
+
+		/* check if any processes are left to run */
+		if (new_q.empty())
+		{
+			std::cerr << "No processes to run" << std::endl;
+			return false;
+		}
+
+		/* if edf fill the vector with 0s */
+		if (P::DEADLINES)
+			wait.assign(tbl.size(), 0);
+	}
+
+	if (env.interactive)
+	{
+		std::cerr << std::endl << "**** INTERACTIVE MODE ****" << std::endl;
+		std::cerr << "To enter next clock cycle, press <enter>" << std::endl;
+		std::cerr << VIEW_HELP;
+		while (std::getline(std::cin, line) && !line.empty())
+			view_command(tbl, line, env);
+	}
+
+	/* from here on the gantt chart is only written by env.gantt */
+	if (env.charting())
+		env.gantt.start(env.outfs, env.packed, env.indexed);
+	return true;
+
+}
+
+
+/*************************************************************************/
+/*! This functions tells whether a run has ticks left: a process is
+		running, or some are still to arrive, ready, held back or doing io.
+    \param new_q is the queue of processes organized by arrival time
+    \param ready_age_q is the queue of processes organized by scheduler
+    \param st is the state of the run
+    \retrun true if there is another tick to run
+*/
+/*************************************************************************/    
+template<typename P>
+bool more_to_run(new_t& new_q, typename P::ready_t& ready_age_q, run_state_t& st)
+{
+	return st.running || !(ready_age_q.empty() && st.io_q.empty() && new_q.empty() && ready_age_q.throttled() == 0);
+}
+
+
+/*************************************************************************/
+/*! This functions runs the clock tick st.Clock of the scheduler described
+		by the policy P, and moves the clock on.
+    \param tbl is the table of all processes
+    \param new_q is the queue of processes organized by arrival time
+    \param ready_age_q is the queue of processes organized by scheduler
+    \param env is the struct of user-provided values
+    \param stats is the statistics of the run
+    \param st is the state of the run
+    \param obs is the observer of the events of the tick
+*/
+/*************************************************************************/    
+template<typename P, typename O>
+void run_tick(proc_table_t& tbl, new_t& new_q, typename P::ready_t& ready_age_q, env_t &env, stats_t &stats, run_state_t& st, O& obs)
+{
+	io_t& io_q = st.io_q;
+	bool& running = st.running;
+	pidx_t& x = st.x;
+	int &tq = st.tq, &org_tq = st.org_tq;
+	std::vector<size_t>& wait = st.wait;
+	size_t Clock = st.Clock;
+	std::string line;
+
+#ifdef _DEBUG
+	/* let us know which iteration is running */
+	if (!env.interactive && Clock % 100 == 0)
+		std::cerr << "*** Now at clock " << Clock << " ***" << std::endl;
+#endif
+
+	if (SHOWING(env, Clock))
+	{
+		std::cerr << "*** Now at clock " << Clock << " u" << env.user_tq;
+		std::cerr << " k" << env.kernel_tq << " a" << env.age_time;
+		if (st.dvfs.active())
+			std::cerr << " " << st.dvfs.mhz() << "MHz";
+		std::cerr << " ***";
+		std::cerr << std::endl;
+	}
+
+	/* do io to all processes in the io_q */
+	do_io(tbl, ready_age_q, io_q, env, Clock, obs);
+
+	/* show the processes of the quotas refreshed now again */
+	do_refresh(ready_age_q, st.bw, Clock);
+
+	/* do aging */
+	if (P::AGING)
+		do_aging(tbl, ready_age_q, env, Clock, obs);
+
+	/* update the ready queue with any new arrivals */
+	if (!new_q.empty())
+		update(tbl, new_q, ready_age_q, Clock, env.bulk_arrivals, obs);
+
+	/* the cpu is still switching to x */
+	bool busy = running;
+	if (running && st.overhead != 0)
+	{
+		st.overhead--;
+		stats.lost++;
+		tbl.switch_ticks[x]++;
+	}
+
+	/* if a process is running */
+	else if (running)
+	{
+		/* below the top frequency a tick of the clock is only part of a
+		 * tick of burst, see dvfs_t
+		 */
+		bool worked = st.dvfs.run(x);
+		tbl.cpu_ticks[x]++;
+		if (worked)
+			tbl.bst[x]--;
+		tq++;
+
+		/* the ticks of io x asks for now, if any: at the end of each cpu
+		 * phase, or a tick before its quantum is over without phases
+		 */
+		int32_t io_len = 0;
+		if (tbl.has_phases(x))
+		{
+			if (worked && --tbl.phase_left[x] == 0 && tbl.bst[x] != 0)
+				io_len = tbl.next_phase(x);
+		}
+		else if (tbl.io[x] != 0 && tq == org_tq-1)
+			io_len = tbl.io[x];
+
+		/* process finished running */
+		if (tbl.bst[x] == 0)
+		{
+			running = false;
+			tbl.state[x] = ST_ENDED;
+
+			/* update stats */
+			tbl.end[x] = Clock;
+			obs.completion(Clock, x);
+			ready_age_q.charge(x, tq);
+		}
+
+		/* io event occurs to an io process */
+		else if (P::IO && io_len != 0)
+		{
+			tbl.state[x] = ST_IO;
+			tbl.io_count[x]++;
+			tbl.io_total[x] += io_len;
+			obs.io_start(Clock, x);
+			io_q.push(tbl, x, io_len, Clock);
+			ready_age_q.charge(x, tq);
+			running = false;
+		}
+
+		/* clock-interrupted */
+		else if (tq == org_tq)
+		{
+			obs.preempt(Clock, x);
+			demote_priority(tbl, x, env);
+			tbl.Clock[x] = Clock; // update the time the process is pushed
+			tbl.state[x] = ST_READY;
+			ready_age_q.charge(x, tq); // before its group is back in the queue
+			ready_age_q.push(x);
+			running = false;				
+		}
+
+	}
+
+	/* charge x for the cpu when it leaves, or when its quota runs out or
+	 * starts a new period, see bandwidth_t
+	 */
+	if (st.bw.charging() && (!running || st.bw.due(Clock)))
+	{
+		bool throttled = st.bw.charge(x, Clock, [&ready_age_q](uint32_t g, int kernel, bool on)
+		{
+			ready_age_q.throttle(g, kernel, on);
+		});
+		if (!running)
+			st.bw.stop();
+
+		/* the quota of x is used up: it waits for the next period */
+		else if (throttled)
+		{
+			obs.throttle(Clock, x);
+			tbl.Clock[x] = Clock;
+			tbl.state[x] = ST_READY;
+			ready_age_q.charge(x, tq);
+			ready_age_q.push(x); // hidden until the quota is refreshed
+			running = false;
+			st.bw.stop();
+		}
+		else
+			st.bw.arm(x);
+	}
+
+	/* if a process is not running, start one that's available */
+	if (!running && !ready_age_q.empty())
+	{
+		/****************** GET NEXT PROCESS ****************/
+		if (P::DEADLINES) /* edf scheduler */
+		{
+			/* find process which can meet its deadline */
+			for (x=ready_age_q.top(); 
+					 Clock+switch_overhead(tbl, x, st, env)+st.dvfs.ticks(x, tbl.bst[x])>(uint64_t) tbl.dline[x];
+					 x=ready_age_q.top())
+			{
+				wait[x] = 0;
+				tbl.state[x] = ST_ABORTED;
+				obs.abort(Clock, x);
+				ready_age_q.pop();
+				stats.np--;
+				if (ready_age_q.empty())
+					break;
+			}
+
+			/* we found a process to run. Remove it from the ready queue. */
+			if (!ready_age_q.empty())
+				ready_age_q.pop();
+		} 
+		else /* non-real time scheduler */
+		{
+			x = ready_age_q.top(); 
+			ready_age_q.pop();
+		}
+
+		/***************** SET UP RUNTIME *******************/
+		st.overhead = switch_overhead(tbl, x, st, env);
+		if (x != st.last)
+			stats.switches++;
+		st.last = x;
+		org_tq = ISKERNEL(tbl.pri[x])? env.kernel_tq: env.user_tq;
+		tq = 0;
+		running = true;				
+		tbl.state[x] = ST_RUNNING;
+		tbl.dispatches[x]++;
+		st.bw.dispatch(x, Clock);
+		if (tbl.start[x] == NOT_STARTED)
+			tbl.start[x] = Clock;
+		obs.dispatch(Clock, x);
+	}
+
+	/* the power of the tick, and the frequency of the next one */
+	st.dvfs.tick(busy, Clock);
+
+	/* print the view and take commands if in interactive mode */
+	if (SHOWING(env, Clock))
+	{
+		print_states<P>(tbl, new_q, ready_age_q, io_q, x, running, org_tq-tq, env, Clock);
+		while (std::getline(std::cin, line) && !line.empty())
+			if (view_command(tbl, line, env))
+				print_states<P>(tbl, new_q, ready_age_q, io_q, x, running, org_tq-tq, env, Clock);
+	}
+
+	/* update wait time. Other schedulers get it from the table at the end */
+	if (P::DEADLINES)
+	{ // need vector of values because we drop those that are aborted.
+		ready_age_q.for_each([&wait](pidx_t i) { wait[i]++; });
+	}
+
+	/* save a checkpoint every checkpoint_every ticks */
+	if (env.checkpoint_every != 0 && (Clock+1) % env.checkpoint_every == 0)
+	{
+		st.Clock = Clock+1;
+		save_checkpoint(tbl, new_q, ready_age_q, st, stats, env);
+	}
+
+	st.Clock = Clock+1;
+}
+
+
+/*************************************************************************/
+/*! This functions ends a run which has no ticks left: the Gantt chart and
+		metrics are written and the stats taken from the state of the run.
+    \param env is the struct of user-provided values
+    \param stats is the statistics of the run
+    \param st is the state of the run
+*/
+/*************************************************************************/    
+template<typename P>
+void end_run(env_t &env, stats_t &stats, run_state_t& st)
+{
+	/* if edf, add all the wait times */
+	if (P::DEADLINES)
+		for (size_t n : st.wait)
+			if (n != 0)
+				stats.np++;
+
+	stop_gantt(env);
+	if (!env.metrics_name.empty())
+		save_metrics(env);
+	stats.devices = st.io_q.device_stats();
+	stats.bandwidth = st.bw.stats();
+	stats.dvfs = st.dvfs.stats();
+}
+
+
+/************************************************************************/
+/*! This functions saves the state of the simulation to the checkpoint
+		file at the end of a clock tick. Only the columns of the process table
+		which change while running are saved; the rest is read again from the
+		process file on resume and checked against the fingerprint.
+		\param tbl is the table of all processes
+		\param new_q is the queue of processes organized by arrival time
+		\param ready_age_q is the queue of processes organized by scheduler
+		\param st is the rest of the state of run_scheduler
+		\param stats is the partially computed statistics
+		\param env is the struct of user-provided values
+*/
+/************************************************************************/ 
+template<typename R>
+void save_checkpoint(proc_table_t& tbl, new_t& new_q, R& ready_age_q, 
+										 run_state_t& st, stats_t& stats, env_t& env)
+{
+	snapshot_writer w;
+	std::vector<pidx_t> ready;
+
+	/* everything printed so far must be in the file before its offset is taken */
+	env.gantt.drain();
+
+	if (!w.open(env.checkpoint_name))
+	{
+		std::cerr << "Could not write checkpoint \'" << env.checkpoint_name << "\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	ready_age_q.sync();
+	ready_age_q.for_each([&ready](pidx_t x) { ready.push_back(x); });
+
+	w.put((uint64_t) CHECKPOINT_MAGIC);
+	w.put(fingerprint(tbl, env));
+	w.put((uint64_t) env.outfs.tellp());
+
+	w.put((uint64_t) st.Clock);
+	w.put(st.running);
+	w.put(st.x);
+	w.put(st.tq);
+	w.put(st.org_tq);
+	w.put(st.last);
+	w.put(st.overhead);
+	w.put((uint64_t) new_q.cursor);
+	w.put(ready);
+	st.io_q.save(w);
+	st.bw.save(w);
+	st.dvfs.save(w);
+	w.put(st.wait);
+	w.put((uint64_t) stats.np);
+	w.put(stats.switches);
+	w.put(stats.lost);
+
+	w.put(tbl.bst);
+	w.put(tbl.pri);
+	w.put(tbl.Clock);
+	w.put(tbl.io_end);
+	w.put(tbl.io_count);
+	w.put(tbl.io_total);
+	w.put(tbl.switch_ticks);
+	w.put(tbl.cpu_ticks);
+	w.put(tbl.phase_next);
+	w.put(tbl.phase_left);
+	w.put(tbl.dispatches);
+	w.put(tbl.start);
+	w.put(tbl.end);
+	w.put(tbl.state);
+	w.put(tbl.groups.vtime);
+	w.put(tbl.groups.floor);
+	env.gantt.save_state(w);
+	if (env.indexed)
+		env.gantt.index.save_state(w);
+
+	if (!w.commit())
+	{
+		std::cerr << "Could not write checkpoint \'" << env.checkpoint_name << "\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+/************************************************************************/
+/*! This functions restores the state saved by save_checkpoint. The table
+		and new_q must have just been read from the same process file and the
+		ready_age_q must be empty. The output file is cut back to where it
+		was when the checkpoint was taken.
+		\param tbl is the table of all processes
+		\param new_q is the queue of processes organized by arrival time
+		\param ready_age_q is the queue of processes organized by scheduler
+		\param st is the rest of the state of run_scheduler
+		\param stats is the partially computed statistics
+		\param env is the struct of user-provided values
+*/
+/************************************************************************/ 
+template<typename R>
+void load_checkpoint(proc_table_t& tbl, new_t& new_q, R& ready_age_q, 
+										 run_state_t& st, stats_t& stats, env_t& env)
+{
+	snapshot_reader r;
+	uint64_t magic=0, print=0, offset=0, Clock=0, cursor=0, np=0;
+	std::vector<pidx_t> ready;
+	size_t n = tbl.size();
+
+	if (!r.open(env.checkpoint_name))
+	{
+		std::cerr << "Could not read checkpoint \'" << env.checkpoint_name << "\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	r.get(magic);
+	r.get(print);
+	if (magic != CHECKPOINT_MAGIC || print != fingerprint(tbl, env))
+	{
+		std::cerr << "The checkpoint \'" << env.checkpoint_name << "\' was not taken ";
+		std::cerr << "with this process file and these options" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	r.get(offset);
+
+	r.get(Clock);
+	r.get(st.running);
+	r.get(st.x);
+	r.get(st.tq);
+	r.get(st.org_tq);
+	r.get(st.last);
+	r.get(st.overhead);
+	r.get(cursor);
+	r.get(ready);
+	bool io_ok = st.io_q.load(r);
+	bool bw_ok = st.bw.load(r);
+	bool dvfs_ok = st.dvfs.load(r);
+	r.get(st.wait);
+	r.get(np);
+	r.get(stats.switches);
+	r.get(stats.lost);
+
+	r.get(tbl.bst);
+	r.get(tbl.pri);
+	r.get(tbl.Clock);
+	r.get(tbl.io_end);
+	r.get(tbl.io_count);
+	r.get(tbl.io_total);
+	r.get(tbl.switch_ticks);
+	r.get(tbl.cpu_ticks);
+	r.get(tbl.phase_next);
+	r.get(tbl.phase_left);
+	r.get(tbl.dispatches);
+	r.get(tbl.start);
+	r.get(tbl.end);
+	r.get(tbl.state);
+	r.get(tbl.groups.vtime);
+	r.get(tbl.groups.floor);
+	env.gantt.load_state(r);
+	if (env.indexed)
+		env.gantt.index.load_state(r);
+
+	if (!r.good() || !io_ok || !bw_ok || !dvfs_ok || cursor > n || tbl.bst.size() != n || tbl.pri.size() != n || 
+			tbl.Clock.size() != n || tbl.io_end.size() != n || tbl.io_count.size() != n || tbl.dispatches.size() != n ||
+			tbl.io_total.size() != n || tbl.switch_ticks.size() != n || tbl.cpu_ticks.size() != n ||
+			tbl.phase_next.size() != n || tbl.phase_left.size() != n ||
+			tbl.start.size() != n || tbl.end.size() != n || tbl.state.size() != n ||
+			tbl.groups.vtime.size() != tbl.groups.size() || tbl.groups.floor.size() != tbl.groups.size())
+	{
+		std::cerr << "The checkpoint \'" << env.checkpoint_name << "\' is corrupt" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	st.Clock = Clock;
+	new_q.cursor = cursor;
+	stats.np = np;
+	st.bw.restore([&ready_age_q](uint32_t g, int kernel, bool on) { ready_age_q.throttle(g, kernel, on); });
+	for (pidx_t x : ready) // the table holds their keys, so the order is rebuilt
+		ready_age_q.push(x);
+	if (!env.metrics_name.empty())
+		env.metrics.rebuild(tbl);
+
+	/* drop whatever was printed after the checkpoint */
+	if (!env.charting())
+		return;
+	env.outfs.close();
+	if (truncate(env.output_name.c_str(), offset) != 0)
+	{
+		std::cerr << "Could not truncate \'" << env.output_name << "\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	env.outfs.open(env.output_name.c_str(), std::ios::app | std::ios::binary);
+}
+
+
+/************************************************************************/
+/*! This functions waits for the Gantt chart to be written and, with
+		--index_output, writes its index next to it.
+		\param env is the struct of user-provided values
+*/
+/************************************************************************/ 
+void stop_gantt(env_t& env)
+{
+	env.gantt.stop();
+	if (env.charting() && env.indexed && !env.gantt.index.save(env.output_name + ".idx", env.packed))
+	{
+		std::cerr << "Could not write index \'" << env.output_name << ".idx\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+/************************************************************************/
+/*! This functions writes the per-process metrics of a run which is
+		done, see proc_metrics_t.
+		\param env is the struct of user-provided values
+*/
+/************************************************************************/ 
+void save_metrics(env_t& env)
+{
+	bool saved;
+	if (env.metrics_csv)
+		saved = env.metrics.save_csv(env.metrics_name + ".csv");
+	else
+		saved = env.metrics.save_binary(env.metrics_name);
+
+	if (!saved)
+	{
+		std::cerr << "Could not write metrics \'" << env.metrics_name << "\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+/************************************************************************/
+/*! This functions identifies a process file and the options which
+		change the course of a run, so a checkpoint is not resumed with
+		anything else. FNV-1a over the options and the columns read from the
+		file.
+		\param tbl is the table of all processes, as read from the file
+		\param env is the struct of user-provided values
+		\retrun the fingerprint
+*/
+/************************************************************************/ 
+uint64_t fingerprint(proc_table_t& tbl, env_t& env)
+{
+	uint64_t h = 14695981039346656037ULL;
+	auto mix = [&h](const void *data, size_t len)
+	{
+		const unsigned char *p = (const unsigned char*) data;
+		for (size_t i=0; i!=len; i++)
+			h = (h ^ p[i]) * 1099511628211ULL;
+	};
+
+	int opts[] = {env.scheduler, env.kernel_tq, env.user_tq, env.age_time, env.age_val, env.packed, env.indexed,
+								env.switch_cost, env.cache_penalty, (int) env.io_devices, env.io_discipline,
+								env.governor, env.governor_sample};
+	uint64_t n = tbl.size();
+	mix(opts, sizeof(opts));
+	mix(&n, sizeof(n));
+	mix(tbl.pid.data(), n * sizeof(int32_t));
+	mix(tbl.arr.data(), n * sizeof(int32_t));
+	mix(tbl.base_bst.data(), n * sizeof(int32_t));
+	mix(tbl.base_pri.data(), n * sizeof(uint8_t));
+	mix(tbl.dline.data(), n * sizeof(int32_t));
+	mix(tbl.io.data(), n * sizeof(int32_t));
+	mix(tbl.dev.data(), n * sizeof(int32_t));
+	mix(tbl.pos.data(), n * sizeof(int32_t));
+	mix(tbl.phase_end.data(), n * sizeof(uint32_t));
+	mix(tbl.phases.data(), tbl.phases.size() * sizeof(int32_t));
+	mix(tbl.group.data(), n * sizeof(uint32_t));
+	for (uint32_t g=0; g!=tbl.groups.size(); g++)
+	{
+		mix(tbl.groups.name[g].c_str(), tbl.groups.name[g].size() + 1);
+		mix(&tbl.groups.shares[g], sizeof(uint32_t));
+	}
+	for (const quota_spec_t& q : env.cpu_quotas)
+	{
+		mix(q.name.c_str(), q.name.size() + 1);
+		mix(&q.quota, sizeof(uint32_t));
+		mix(&q.period, sizeof(uint32_t));
+	}
+	mix(env.cpu_levels.data(), env.cpu_levels.size() * sizeof(cpu_level_t));
+	return h;
+}
+
+
+/************************************************************************/
+/*! This functions reduces the process table into the statistics once the
+		scheduler is done. Every process which ran to completion spent
+		end-arr ticks in the system, of which cpu_ticks were running (more
+		than its burst below the top frequency, see dvfs_t), switch_ticks
+		switching to it and io_total doing io; the rest it was waiting in
+		the ready queue; a process an edf trunk aborted before a branch
+		is not counted.
+		The totals are summed column by column (see simd.h).
+		\param tbl is the table of all processes
+		\param waits is true if the awt should be computed from the table
+*/
+/************************************************************************/ 
+void stats_t::reduce(const proc_table_t& tbl, bool waits)
+{
+	size_t n = tbl.size();
+	uint64_t total_end = sum_column(tbl.end.data(), n);
+
+	att = (double) total_end;
+	span = n? *std::max_element(tbl.end.begin(), tbl.end.end()): 0;
+	uint64_t total_wait = 0;
+	if (waits)
+		total_wait = total_end
+			- sum_column(tbl.arr.data(), n)
+			- sum_column(tbl.cpu_ticks.data(), n)
+			- sum_column(tbl.switch_ticks.data(), n)
+			- sum_column(tbl.io_total.data(), n);
+
+	for (pidx_t x=0; x!=n; x++)
+		if (tbl.end[x] != NOT_ENDED)
+			record(tbl, x);
+		else if (waits) // aborted, its end is 0: take back what it added
+			total_wait += tbl.arr[x] + tbl.cpu_ticks[x] + tbl.switch_ticks[x] + tbl.io_total[x];
+	if (waits)
+		awt = (double) total_wait;
+
+	groups.clear();
+	if (tbl.groups.size() > 1)
+		reduce_groups(tbl);
+}
+
+
+/************************************************************************/
+/*! This functions sums the processes of each group into its statistics,
+		then those of each group into the group above it. A group is always
+		after the group above it in the tree.
+		\param tbl is the table of all processes
+*/
+/************************************************************************/ 
+void stats_t::reduce_groups(const proc_table_t& tbl)
+{
+	const group_tree_t& tree = tbl.groups;
+
+	groups.assign(tree.size(), group_stats_t());
+	for (uint32_t g=0; g!=tree.size(); g++)
+	{
+		groups[g].name = tree.name[g];
+		groups[g].shares = tree.shares[g];
+	}
+
+	for (pidx_t x=0; x!=tbl.size(); x++)
+	{
+		group_stats_t& g = groups[tbl.group[x]];
+		g.procs++;
+		g.cpu += tbl.cpu_ticks[x];
+		if (tbl.end[x] != NOT_ENDED)
+		{
+			uint64_t tt = tbl.end[x] - tbl.arr[x];
+			g.ended++;
+			g.turnaround += tt;
+			g.wait += tt - tbl.cpu_ticks[x] - tbl.switch_ticks[x] - tbl.io_total[x];
+		}
+	}
+
+	for (uint32_t g=(uint32_t) tree.size()-1; g!=ROOT_GROUP; g--)
+	{
+		group_stats_t& up = groups[tree.parent[g]];
+		up.procs += groups[g].procs;
+		up.ended += groups[g].ended;
+		up.cpu += groups[g].cpu;
+		up.wait += groups[g].wait;
+		up.turnaround += groups[g].turnaround;
+	}
+
+	/* printed by name, so each group is just above its subgroups */
+	std::sort(groups.begin(), groups.end(),
+						[](const group_stats_t& lhs, const group_stats_t& rhs) { return lhs.name < rhs.name; });
+}
+
+
+/************************************************************************/
+/*! This functions adds a terminated process to the percentile sketches.
+		\param tbl is the table of all processes
+		\param x is the process which terminated
+*/
+/************************************************************************/ 
+void stats_t::record(const proc_table_t& tbl, pidx_t x)
+{
+	uint64_t tt = tbl.end[x] - tbl.arr[x];
+	uint64_t rt = tbl.start[x] - tbl.arr[x];
+	uint64_t wt = tt - tbl.cpu_ticks[x] - tbl.switch_ticks[x] - tbl.io_total[x];
+
+	class_stats_t *classes[] = {
+		&all,
+		ISKERNEL(tbl.base_pri[x])? &kernel: &user,
+		&band[tbl.base_pri[x] / BAND_WIDTH]
+	};
+
+	for (class_stats_t *c : classes)
+	{
+		c->wt.record(wt);
+		c->tt.record(tt);
+		c->rt.record(rt);
+	}
+}
+
+
+/************************************************************************/
+/*! This functions performs one iteration of io. If a process finishes
+		its io it is moved to the ready_age_q. Only the processes whose io
+		ends at Clock are looked at, see io_t.
+    \param tbl is the table of all processes
+    \param ready_age_q is the queue of processes organized by scheduler
+    							 		 with a synchronized age queue
+    \param io_q is the processes currently doing io
+    \param env is the struct containing user-defined values
+    \param obs is the observer of the events of the run
+*/
+/************************************************************************/ 
+template<typename R, typename O>
+void do_io(proc_table_t& tbl, R& ready_age_q, io_t& io_q, env_t& env, size_t Clock, O& obs)
+{
+	/* each process whose io is completed */
+	io_q.complete(tbl, Clock, [&](pidx_t x)
+	{
+		/* update priority */
+		promote_priority(tbl, x, IO, env);
+
+		/* add to ready queue */
+		if (ISMAXED(tbl.pri[x]))
+			tbl.Clock[x] = CLOCK_LAST;
+		else
+			tbl.Clock[x] = Clock; // update the clock when the process is pushed
+		tbl.state[x] = ST_READY;
+		ready_age_q.push(x);
+		obs.io_end(Clock, x);
+	});
+}
+
+
+/************************************************************************/
+/*! This functions refreshes the cpu quotas whose next period starts at
+		Clock, so the processes they held back can run again, see bandwidth_t.
+    \param ready_age_q is the queue of processes organized by scheduler
+    \param bw is the cpu quotas
+    \param Clock is the current time of execution
+*/
+/************************************************************************/ 
+template<typename R>
+void do_refresh(R& ready_age_q, bandwidth_t& bw, size_t Clock)
+{
+	bw.refresh(Clock, [&ready_age_q](uint32_t g, int kernel, bool on)
+	{
+		ready_age_q.throttle(g, kernel, on);
+	});
+}
+
+
+/************************************************************************/
+/*! This functions ages each process in the ready queue. If the process
+		has aged, its priority is promoted.
+    \param tbl is the table of all processes
+    \param ready_age_q is the queue of processes organized by scheduler
+    \param env is the struct containing user-defined values
+    \param Clock is the current time of execution
+    \param obs is the observer of the events of the run
+*/
+/************************************************************************/ 
+template<typename T, typename O>
+void do_aging(proc_table_t& tbl, ready_age_t<T>& ready_age_q, env_t& env, size_t Clock, O& obs)
+{
+	std::vector<pidx_t> aged;
+	ready_age_q.expired(Clock, aged);
+
+	/* for each process which waited age_time in the ready queue */
+	for (pidx_t x : aged)
+	{
+		obs.aging(Clock, x);
+
+		/* unlink before the keys of x change */
+		ready_age_q.erase(x);
+
+		promote_priority(tbl, x, AGE, env);
+		if (ISMAXED(tbl.pri[x]))
+			tbl.Clock[x] = CLOCK_LAST;
+		else
+			tbl.Clock[x] = Clock;
+
+		ready_age_q.push(x);
+	}
+}
+
+
+/************************************************************************/
+/*! This functions ages the lazy ready queue of the priority scheduler.
+		Processes are only looked at here if the observer wants their aging.
+		The table and the options, taken as by the other do_aging, are
+		those the queue was made with.
+    \param ready_age_q is the queue of processes organized by scheduler
+    \param Clock is the current time of execution
+    \param obs is the observer of the events of the run
+*/
+/************************************************************************/ 
+template<typename O>
+void do_aging(proc_table_t&, lazy_ready_t& ready_age_q, env_t&, size_t Clock, O& obs)
+{
+	if (!obs.wants_aging(Clock))
+	{
+		ready_age_q.age(Clock, NULL);
+		return;
+	}
+
+	std::vector<pidx_t> aged;
+	ready_age_q.age(Clock, &aged);
+	for (pidx_t x : aged)
+		obs.aging(Clock, x);
+}
+
+
+/************************************************************************/
+/*! This functions ages the ready queue of every group. Ageing changes
+		the order of a group's processes, not which groups have some.
+    \param tbl is the table of all processes
+    \param ready_age_q is the queue of processes organized by scheduler
+    \param env is the struct containing user-defined values
+    \param Clock is the current time of execution
+    \param obs is the observer of the events of the run
+*/
+/************************************************************************/ 
+template<typename R, typename O>
+void do_aging(proc_table_t& tbl, group_ready_t<R>& ready_age_q, env_t& env, size_t Clock, O& obs)
+{
+	for (uint32_t g=0; g!=tbl.groups.size(); g++)
+		if (tbl.groups.is_leaf(g))
+			for (int kernel=0; kernel!=(tbl.groups.by_class? 2: 1); kernel++)
+				do_aging(tbl, ready_age_q.queue(g, kernel), env, Clock, obs);
+}
+
+
+/************************************************************************/
+/*! This functions gives the ticks the cpu spends switching to x before
+		x runs. Giving the cpu back to the process which had it is free; any
+		other costs switch_cost, plus cache_penalty if x ran before, as its
+		cache has been taken over since.
+		\param tbl is the table of all processes
+		\param x is the process to dispatch
+		\param st is the state of run_scheduler
+		\param env is the struct of user-provided values
+		\retrun the overhead in ticks
+*/
+/************************************************************************/ 
+int switch_overhead(const proc_table_t& tbl, pidx_t x, const run_state_t& st, const env_t& env)
+{
+	if (x == st.last)
+		return 0;
+	return env.switch_cost + (tbl.dispatches[x] != 0? env.cache_penalty: 0);
+}
+
+
+/************************************************************************/
+/*! This functions demotes the priority of clock-interrupted process.
+		The priority is decremented by the time-quantum corresponding to the
+		type of process (user or kernel). Arithmetic is restricted to [0,49]
+		for user processes and to [50,99] for kernel processes.
+    \param tbl is the table of all processes
+    \param x is the current process to be demoted
+*/
+/************************************************************************/    
+void demote_priority(proc_table_t& tbl, pidx_t x, env_t& env)
+{
+	int pri = tbl.pri[x];
+	if (ISKERNEL(pri)) // kernel process
+	{ 
+		pri -= env.kernel_tq;
+		if (pri < 50)
+			pri = 50;
+	}
+	else // user process
+	{
+		pri -= env.user_tq;
+		if (pri < 0)
+			pri = 0;
+	}
+	tbl.pri[x] = (uint8_t) pri;
+}
+
+
+/************************************************************************/
+/*! This functions promotes the priority of IO/aging process.
+		If IO, the priority is incremented corresponding to the io-number.
+		If AGE, the priority is incremented corresponding to age_value. 
+		type of process (user or kernel). Arithmetic is restricted to [0,49]
+		for user processes and to [50,99] for kernel processes.
+    \param tbl is the table of all processes
+    \param x is the current process to be demoted
+    \param op is type of operation {IO, AGE}
+    \param env is the struct of user-defined input values
+*/
+/************************************************************************/ 
+void promote_priority(proc_table_t& tbl, pidx_t x, ops_t op, env_t& env)
+{
+	int old_pri = tbl.pri[x];
+	int pri = old_pri + (op==IO? tbl.io_len(x): env.age_val);
+
+	if (ISKERNEL(old_pri)) // kernel process
+	{
+		if (pri >= 99)
+			pri = 99;
+	}
+	else if (pri >= 49) // user process
+		pri = 49;
+	tbl.pri[x] = (uint8_t) pri;
+}
+
+
+/***********************************************************************/
+/*! This functions transfers arriving processes from new_q to ready_age_q.
+		The processes arriving at the same tick are next to each other in
+		new_q; bulk of them or more are pushed in one batch (see
+		priority_queue::push_bulk), which only pays once the ready queue
+		no longer fits in the cache.
+    \param tbl is the table of all processes
+    \param new_q is the queue of processes organized by arrival time
+    \param ready_age_q is the queue of processes organized by scheduler
+    \param Clock is the current clock-tick
+    \param bulk is the arrivals at a tick from which they are pushed in one batch
+    \param obs is the observer of the events of the run
+*/
+/***********************************************************************/    
+template<typename R, typename O>
+void update(proc_table_t& tbl, new_t& new_q, R& ready_age_q, size_t Clock, size_t bulk, O& obs)
+{
+	/* following assertion is assumed */
+	assert(!new_q.empty()); // new_q is not empty
+
+	/* the earliest elements in new_q which have arrived */
+	new_t::iterator first = new_q.begin(), last = first;
+	for (; last != new_q.end() && (size_t) tbl.arr[*last] == Clock; ++last)
+	{
+		pidx_t x = *last;
+		if (ISMAXED(tbl.pri[x]))
+			tbl.Clock[x] = CLOCK_LAST;
+		else
+			tbl.Clock[x] = Clock; // the time the process arrived
+		tbl.state[x] = ST_READY;
+	}
+
+	if ((size_t) (last - first) >= bulk)
+		ready_age_q.push_bulk(first, last);
+	else
+		for (new_t::iterator x = first; x != last; ++x)
+			ready_age_q.push(*x);
+
+	new_q.cursor += last - first;
+	for (; first != last; ++first)
+		obs.arrival(Clock, *first);
+}
+
+
+/***********************************************************************/
+/*! This functions prints the output during interactive running. Only
+		the processes in the view (env.view) are looked at, so a step costs
+		the same whatever the number of processes. Their state is kept in
+		the table by the scheduler.
+		\param tbl is the table of all processes
+		\param new_q is the new queue
+		\param ready_age_q is the ready_q following a scheduler protocol
+		\param io_q is the queue of all I/O processes (wait queue)
+		\param x is the running process if running=true and nonesense otherwise
+		\param running is a flag to identify if x is running or meaningless
+		\param tq is the time left in the quantum of x
+		\param env is the struct of user-provided values
+		\param Clock is the current clock
+*/
+/***********************************************************************/
+template<typename P>
+void print_states(proc_table_t& tbl, new_t& new_q, typename P::ready_t& ready_age_q, io_t& io_q, pidx_t x, bool running, int tq, env_t& env, size_t Clock)
+{
+	static const char *names[] = {"new", "ready", "running", "io", "end", "abort"};
+
+	view_t& v = env.view;
+	v.build(tbl);
+
+	size_t n = tbl.size();
+	size_t first = std::min(v.first, n), last = std::min(v.first + v.rows, n);
+	size_t nended = n - new_q.size() - ready_age_q.size() - ready_age_q.throttled() - io_q.size() - (running==true);
+
+	/* the lazy ready queue only works out the priority of the processes shown */
+	for (size_t i=first; i!=last; i++)
+		if (tbl.state[v.by_pid[i]] == ST_READY)
+			ready_age_q.sync(v.by_pid[i]);
+
+	std::cout << std::endl;
+
+	std::cout << "RUNNING:\t";
+	if (running)
+		std::cout << "pid: " << tbl.pid[x] << " (tq: " << tq << ")";
+	else
+		std::cout << "none";
+	std::cout << std::endl;
+
+	std::cout << "COUNT:\t\tnew " << new_q.size() << "\tready " << ready_age_q.size();
+	std::cout << "\tio " << io_q.size();
+	if (ready_age_q.throttled() != 0)
+		std::cout << "\tthrottled " << ready_age_q.throttled();
+	std::cout << "\tended " << nended << std::endl;
+
+	std::cout << "VIEW:\t\t";
+	if (first != last)
+		std::cout << "pid " << tbl.pid[v.by_pid[first]] << " to " << tbl.pid[v.by_pid[last-1]];
+	std::cout << " (" << first+1 << "-" << last << " of " << n << ")" << std::endl;
+
+	std::cout << "IO-QUEUE:";
+	for (size_t i=first; i!=last; i++)
+	{
+		pidx_t y = v.by_pid[i];
+		if (tbl.state[y] == ST_IO)
+			std::cout << "\t" << tbl.pid[y] << "(" << (tbl.io_end[y] == IO_QUEUED? tbl.io_len(y): tbl.io_end[y]-Clock) << ")";
+	}
+	std::cout << std::endl;
+	std::cout << std::endl;
+
+	std::cout << "STATE:\t";
+	for (size_t i=first; i!=last; i++)
+		std::cout << "\t" << names[tbl.state[v.by_pid[i]]];
+	std::cout << std::endl;
+
+	std::cout << "PID:\t";
+	for (size_t i=first; i!=last; i++)
+		std::cout << "\t" << tbl.pid[v.by_pid[i]] << "(" << (ISKERNEL(tbl.pri[v.by_pid[i]])? 'k': 'u') << ")";
+	std::cout << std::endl;
+
+	if (P::AGING)
+	{
+		std::cout << "PRIORITY:";
+		for (size_t i=first; i!=last; i++)
+			std::cout << "\t" << (int) tbl.pri[v.by_pid[i]];
+		std::cout << std::endl;	
+	}
+
+	std::cout << "BURST:\t";
+	for (size_t i=first; i!=last; i++)
+		std::cout << "\t" << tbl.bst[v.by_pid[i]];
+	std::cout << std::endl;
+
+	std::cout << "ARRIVAL:";
+	for (size_t i=first; i!=last; i++)
+		std::cout << "\t" << tbl.arr[v.by_pid[i]];
+	std::cout << std::endl;
+
+	if (P::AGING)
+	{
+		std::cout << "Clock:\t";
+		for (size_t i=first; i!=last; i++)
+		{
+			if (tbl.Clock[v.by_pid[i]] == CLOCK_LAST)
+				std::cout << "\t" << (int) -1;
+			else
+				std::cout << "\t" << tbl.Clock[v.by_pid[i]];
+		}
+		std::cout << std::endl;
+	}
+
+	if (P::IO)
+	{
+		std::cout << "IO:\t";
+		for (size_t i=first; i!=last; i++)
+			std::cout << "\t" << tbl.io[v.by_pid[i]];
+		std::cout << std::endl;
+	}
+
+	if (P::DEADLINES)
+	{
+		std::cout << "DLINE:\t";
+		for (size_t i=first; i!=last; i++)
+			std::cout << "\t" << tbl.dline[v.by_pid[i]];
+		std::cout << std::endl;
+	}
+
+	std::cout << std::endl;
+}
+
+
+/***********************************************************************/
+/*! This functions runs one command typed in interactive mode (see
+		VIEW_HELP).
+		\param tbl is the table of all processes
+		\param line is the command
+		\param env is the struct of user-provided values
+		\retrun true if the view changed and should be printed again
+*/
+/***********************************************************************/
+bool view_command(proc_table_t& tbl, const std::string& line, env_t& env)
+{
+	view_t& v = env.view;
+	std::istringstream is(line);
+	std::string cmd;
+	long long arg = 0;
+
+	is >> cmd;
+	bool has_arg = (bool) (is >> arg);
+
+	if (cmd == "c" && has_arg && arg >= 0)
+	{
+		v.stop_at = arg;
+		return false;
+	}
+	else if (cmd == "q")
+	{
+		v.stop_at = (size_t) -1;
+		return false;
+	}
+	else if (cmd == "p" && has_arg)
+	{
+		v.build(tbl);
+		auto iter = std::lower_bound(v.by_pid.begin(), v.by_pid.end(), arg,
+																 [&tbl](pidx_t y, long long pid) { return tbl.pid[y] < pid; });
+		v.first = iter - v.by_pid.begin();
+		return true;
+	}
+	else if (cmd == "n")
+	{
+		if (v.first + v.rows < tbl.size())
+			v.first += v.rows;
+		return true;
+	}
+	else if (cmd == "b")
+	{
+		v.first = v.first > v.rows? v.first - v.rows: 0;
+		return true;
+	}
+	else if (cmd == "r" && has_arg && arg > 0)
+	{
+		v.rows = arg;
+		return true;
+	}
+
+	std::cerr << "Unknown command \'" << line << "\'" << std::endl << VIEW_HELP;
+	return false;
+}
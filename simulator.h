@@ -0,0 +1,393 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bandwidth.h"
+#include "dvfs.h"
+#include "gantt_format.h"
+#include "groups.h"
+#include "histogram.h"
+#include "io_devices.h"
+#include "PCB.h"
+
+/**************************************************
+ ********************* MACROS *********************
+ *************************************************/
+
+#define DEFAULT_AGE_TIME 100
+#define DEFAULT_AGE_VALUE 10
+#define DEFAULT_KERNEL_QUANTUM 100
+#define DEFAULT_USER_QUANTUM 25
+#define DEFAULT_SCHEDULER "priority"
+#define MAX_IO_DEVICES 65536
+#define BULK_ARRIVALS 4096 // arrivals at a tick from which they are pushed in one batch
+#define NO_FORK ((size_t) -1)
+
+/*************************************************
+ ******************** TYPES **********************
+ ************************************************/
+
+/* enum to help identify which scheduler to user */
+enum scheduler_t 
+{
+	FIFO,
+	SJF,
+	PRIORITY,
+	EDF,
+	SCHEDULERS
+};
+
+static const char *const scheduler_name[SCHEDULERS] =
+{
+	"fifo",
+	"sjf",
+	"priority",
+	"edf"
+};
+
+/* a scheduler to continue with after the fork clock in what-if mode */
+struct branch_t
+{
+	scheduler_t scheduler;
+	int user_tq;
+	int kernel_tq;
+};
+
+/* user provided input values. An empty output_name writes no Gantt chart. */
+struct sim_config_t 
+{
+	int kernel_tq;
+	int user_tq;
+	int age_time;
+	int age_val;
+	int switch_cost; // ticks the cpu is lost on a context switch
+	int cache_penalty; // extra ticks when a process which ran before resumes after another
+	size_t io_devices; // io devices, 0 for infinitely parallel io
+	io_discipline_t io_discipline; // order a device serves its queue in
+	bool interactive;
+	bool lazy_aging; // age the priority scheduler with lazy_ready_t
+	scheduler_t scheduler;
+	std::string file_name;
+	std::string output_name;
+	bool packed; // write the chart in the packed format of gantt_format.h
+	bool indexed; // write <output_name>.idx, see gantt_index.h
+	std::string metrics_name; // per-process metrics file, empty for none
+	bool metrics_csv; // write it as csv rather than columns
+	size_t checkpoint_every; // ticks between checkpoints, 0 for none
+	std::string checkpoint_name;
+	bool resume;
+	size_t fork_at; // clock at which to stop and run the branches
+	std::vector<branch_t> branches;
+	std::vector<std::pair<std::string, uint32_t> > group_shares; // shares of the groups named
+	std::vector<quota_spec_t> cpu_quotas; // bandwidth limits, see bandwidth_t
+	governor_t governor; // of the cpu frequency, GOV_NONE for no frequency model
+	int governor_sample; // ticks between the looks of ondemand at the load
+	std::vector<cpu_level_t> cpu_levels; // sorted by frequency, see dvfs_t
+	size_t bulk_arrivals; // arrivals at a tick from which they are pushed in one batch, (size_t) -1 for never
+
+	sim_config_t()
+	{
+		kernel_tq = DEFAULT_KERNEL_QUANTUM;
+		user_tq = DEFAULT_USER_QUANTUM;
+		age_time = DEFAULT_AGE_TIME;
+		age_val = DEFAULT_AGE_VALUE;
+		switch_cost = cache_penalty = 0;
+		io_devices = 0;
+		io_discipline = IO_FIFO;
+		interactive = lazy_aging = false;
+		scheduler = PRIORITY;
+		packed = indexed = metrics_csv = resume = false;
+		checkpoint_every = 0;
+		fork_at = NO_FORK;
+		governor = GOV_NONE;
+		governor_sample = DEFAULT_GOVERNOR_SAMPLE;
+		bulk_arrivals = BULK_ARRIVALS;
+	}
+
+	void print() const
+	{
+		std::cerr << "kernel_tq: " << kernel_tq << std::endl;
+		std::cerr << "user_tq: " << user_tq << std::endl;
+		std::cerr << "age_time: " << age_time << std::endl;
+		std::cerr << "age_value: " << age_val << std::endl;
+		std::cerr << "switch_cost: " << switch_cost << std::endl;
+		std::cerr << "cache_penalty: " << cache_penalty << std::endl;
+		std::cerr << "io_devices: " << io_devices << std::endl;
+		std::cerr << "io_discipline: " << io_discipline << std::endl;
+		std::cerr << "lazy_aging: " << lazy_aging << std::endl;
+		std::cerr << "scheduler: " << scheduler << std::endl;
+		std::cerr << "file-name: " << file_name << std::endl;
+		std::cerr << "packed: " << packed << std::endl;
+		std::cerr << "indexed: " << indexed << std::endl;
+		std::cerr << "metrics: " << metrics_name << (metrics_csv? " (csv)": "") << std::endl;
+		std::cerr << "checkpoint: " << checkpoint_every << std::endl;
+		std::cerr << "fork_at: " << fork_at << " (" << branches.size() << " branches)" << std::endl;
+		std::cerr << "group_shares: " << group_shares.size() << " groups" << std::endl;
+		std::cerr << "cpu_quotas: " << cpu_quotas.size() << " limits" << std::endl;
+		std::cerr << "governor: " << governor_name[governor] << " (" << cpu_levels.size() << " levels)" << std::endl;
+		std::cerr << "bulk_arrivals: " << bulk_arrivals << std::endl;
+		std::cerr << std::endl; 
+ 	}
+};
+
+/* percentile sketches of one class of processes */
+struct class_stats_t
+{
+	histogram wt; // waiting time
+	histogram tt; // turnaround time
+	histogram rt; // response time
+
+	void print(const char *name) const
+	{
+		if (tt.count() == 0)
+			return;
+
+		print_row(name, "wait", wt);
+		print_row(name, "turn", tt);
+		print_row(name, "resp", rt);
+	}
+
+	static void print_row(const char *name, const char *metric, const histogram& h)
+	{
+		printf("%-10s%-6s%10llu%12llu%12llu%12llu%12llu\n", name, metric,
+					 (unsigned long long) h.count(),
+					 (unsigned long long) h.quantile(0.50),
+					 (unsigned long long) h.quantile(0.95),
+					 (unsigned long long) h.quantile(0.99),
+					 (unsigned long long) h.max());
+	}
+};
+
+/* object useful for computing average waiting and turnaround time.
+ * The per-class sketches are split by user/kernel and by priority band
+ * (of the priority read from the file) and use constant memory.
+ */
+struct stats_t
+{
+	double awt, att;
+	size_t np;
+	uint64_t switches; // dispatches of a process other than the last one to run
+	uint64_t lost; // ticks the cpu spent switching
+	uint64_t span; // clock of the last termination
+	std::vector<io_device_stats_t> devices; // none if io is infinitely parallel
+	std::vector<group_stats_t> groups; // none if the processes are not in groups
+	std::vector<bandwidth_stats_t> bandwidth; // none without --cpu_quota
+	dvfs_stats_t dvfs; // governor GOV_NONE without --governor
+
+	enum { NBANDS = 4, BAND_WIDTH = 25 };
+	class_stats_t all, user, kernel, band[NBANDS];
+
+	stats_t()
+	{
+		awt = att = 0.0;
+		np = 0;
+		switches = lost = span = 0;
+	}
+
+	void reduce(const proc_table_t&, bool);
+	void reduce_groups(const proc_table_t&);
+	void record(const proc_table_t&, pidx_t);
+
+	void print() const
+	{
+		printf("NP: %zu\n", np);
+		printf("AWT: %.3f\n", awt);
+		printf("ATT: %.3f\n", att);
+		if (lost != 0)
+		{
+			printf("SWITCHES: %llu\n", (unsigned long long) switches);
+			printf("SWITCH TIME: %llu (%.2f%% of the run)\n", (unsigned long long) lost, 
+						 span? 100.0 * lost / span: 0.0);
+		}
+		if (dvfs.governor != GOV_NONE)
+		{
+			uint64_t ticks = dvfs.ticks();
+			printf("GOVERNOR: %s (%llu frequency changes)\n", governor_name[dvfs.governor], 
+						 (unsigned long long) dvfs.changes);
+			printf("ENERGY: %.3f mJ (%.3f mW on average)\n", dvfs.energy_mj(), 
+						 ticks? 1000.0 * dvfs.energy_mj() / ticks: 0.0);
+		}
+
+		printf("\n%-10s%-6s%10s%12s%12s%12s%12s\n", 
+					 "CLASS", "METRIC", "N", "P50", "P95", "P99", "MAX");
+		all.print("all");
+		user.print("user");
+		kernel.print("kernel");
+		for (int i=0; i!=NBANDS; i++)
+		{
+			char name[16];
+			snprintf(name, sizeof(name), "pri%d-%d", i*BAND_WIDTH, (i+1)*BAND_WIDTH-1);
+			band[i].print(name);
+		}
+
+		if (!devices.empty())
+		{
+			printf("\n%-10s%10s%10s%12s%12s%12s\n", 
+						 "DEVICE", "REQUESTS", "BUSY%", "AVG-QUEUE", "MAX-QUEUE", "AVG-WAIT");
+			for (size_t i=0; i!=devices.size(); i++)
+			{
+				const io_device_stats_t& d = devices[i];
+				printf("%-10zu%10llu%10.2f%12.3f%12llu%12.3f\n", i, (unsigned long long) d.requests,
+							 span? 100.0 * d.busy / span: 0.0, span? (double) d.area / span: 0.0,
+							 (unsigned long long) d.max_queue, d.requests? (double) d.wait / d.requests: 0.0);
+			}
+		}
+
+		/* throughput is processes ended per 1000 ticks */
+		if (!groups.empty())
+		{
+			printf("\n%-20s%8s%8s%8s%8s%10s%12s%12s\n", 
+						 "GROUP", "SHARES", "PROCS", "ENDED", "CPU%", "END/1KT", "AVG-WAIT", "AVG-TURN");
+			for (const group_stats_t& g : groups)
+				printf("%-20s%8u%8llu%8llu%8.2f%10.3f%12.3f%12.3f\n", g.name.empty()? "-": g.name.c_str(),
+							 g.shares, (unsigned long long) g.procs, (unsigned long long) g.ended,
+							 span? 100.0 * g.cpu / span: 0.0, span? 1000.0 * g.ended / span: 0.0,
+							 g.ended? (double) g.wait / g.ended: 0.0, g.ended? (double) g.turnaround / g.ended: 0.0);
+		}
+
+		/* periods are those in which the limit had cpu */
+		if (!bandwidth.empty())
+		{
+			printf("\n%-20s%12s%10s%10s%12s%12s\n", 
+						 "QUOTA", "LIMIT", "PERIODS", "THROTTLES", "THROTTLED", "THROTTLED%");
+			for (const bandwidth_stats_t& b : bandwidth)
+			{
+				char limit[32];
+				snprintf(limit, sizeof(limit), "%u/%u", b.quota, b.period);
+				printf("%-20s%12s%10llu%10llu%12llu%12.2f\n", b.name.c_str(), limit, 
+							 (unsigned long long) b.periods, (unsigned long long) b.throttles,
+							 (unsigned long long) b.throttled, span? 100.0 * b.throttled / span: 0.0);
+			}
+		}
+
+		/* a tick is taken as a millisecond */
+		if (dvfs.governor != GOV_NONE)
+		{
+			uint64_t ticks = dvfs.ticks();
+			printf("\n%-10s%10s%10s%12s%12s%10s%12s\n", 
+						 "MHZ", "BUSY-MW", "IDLE-MW", "BUSY", "IDLE", "TIME%", "ENERGY-MJ");
+			for (size_t i=0; i!=dvfs.levels.size(); i++)
+			{
+				const cpu_level_t& l = dvfs.levels[i];
+				printf("%-10u%10u%10u%12llu%12llu%10.2f%12.3f\n", l.mhz, l.busy_mw, l.idle_mw,
+							 (unsigned long long) dvfs.busy[i], (unsigned long long) dvfs.idle[i],
+							 ticks? 100.0 * (dvfs.busy[i] + dvfs.idle[i]) / ticks: 0.0,
+							 (dvfs.busy[i] * (double) l.busy_mw + dvfs.idle[i] * (double) l.idle_mw) / 1000.0);
+			}
+		}
+	}
+};
+
+/* what happened to a process, in the order it can happen (see observers.h) */
+enum sim_event_kind_t
+{
+	SIM_ARRIVAL, // it entered the ready queue for the first time
+	SIM_AGING, // its priority was raised for waiting age_timer ticks
+	SIM_DISPATCH, // it got the cpu
+	SIM_PREEMPT, // its quantum was over
+	SIM_THROTTLE, // its cpu quota was used up
+	SIM_IO_START, // it left the cpu for io
+	SIM_IO_END, // its io was done and it is ready again
+	SIM_ABORT, // it could not meet its deadline (edf)
+	SIM_COMPLETION, // its burst was done
+	SIM_EVENTS
+};
+
+static const char *const sim_event_name[SIM_EVENTS] =
+{
+	"arrival",
+	"aging",
+	"dispatch",
+	"preempt",
+	"throttle",
+	"io_start",
+	"io_end",
+	"abort",
+	"completion"
+};
+
+/* an event of a run, as the scheduler runs */
+struct sim_event_t
+{
+	size_t Clock;
+	int32_t pid;
+	sim_event_kind_t kind;
+};
+
+/* called with each event of a run */
+typedef std::function<void(const sim_event_t&)> event_handler_t;
+
+/* The scheduler simulator, to be embedded: everything the command line
+ * does, without globals, so any number of them can run in one process,
+ * each on its own thread.
+ *
+ *   Simulator sim;
+ *   sim.configure(config);
+ *   if (!sim.load("processes"))
+ *     ... sim.error() ...
+ *   sim.subscribe([](const sim_event_t& e) { ... });
+ *   sim.run(); // or while (sim.step()) ...
+ *   ... sim.stats() ...
+ *
+ * The Gantt chart, metrics and checkpoints are written to the files the
+ * configuration names, if any. The handlers are called through
+ * std::function; a run with no output and no handlers is built without
+ * any observer, so it does nothing but schedule. A run forked into
+ * branches runs them at the fork clock; their statistics are then in
+ * branch_stats(), those of the run itself up to the fork in stats().
+ */
+class Simulator
+{
+private:
+	struct impl_t; // the process table, the queues and the output of the run
+	std::unique_ptr<impl_t> impl;
+
+public:
+	Simulator();
+	~Simulator();
+
+	/* the options of the run, before load() */
+	void configure(const sim_config_t& config);
+
+	/* reads the processes of a process file and checks them against the
+	 * configuration.
+	 * \retrun false if they cannot be run, with the reason in error()
+	 */
+	bool load(const std::string& file_name);
+
+	/* handler is called with every event of the run, not of its branches.
+	 * The run is built with its handlers on its first step.
+	 * \retrun false, and handler is not subscribed, once the run started
+	 */
+	bool subscribe(const event_handler_t& handler);
+
+	/* runs a clock tick.
+	 * \retrun false once the run is over, or forked into its branches
+	 */
+	bool step();
+
+	/* runs to the end.
+	 * \retrun false if the run was forked into branches
+	 */
+	bool run();
+
+	/* the next tick to run */
+	size_t clock() const;
+
+	/* averaged once the run is over */
+	const stats_t& stats() const;
+
+	/* of each branch, in the order given, once the run is forked */
+	const std::vector<stats_t>& branch_stats() const;
+
+	const std::string& error() const;
+};
+
+#endif
@@ -0,0 +1,560 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "gantt_format.h"
+#include "options.h"
+#include "simulator.h"
+
+/* The tests of the simulator library, run by 'make test'. Each writes a
+ * small process file, runs it with the Simulator and checks what came
+ * out; a check which fails is printed, and the program fails once all
+ * of them ran.
+ */
+
+#define TEST_FILE "test-processes" // written and removed by each test
+#define TEST_CHART "test-gantt" // the Gantt chart of a test, removed by it
+#define TEST_CHECKPOINT "test-checkpoint" // the checkpoint of a test, removed by it
+
+static int failures = 0;
+
+#define CHECK(test, cond) \
+	do { if (!(cond)) { std::cerr << test << ": failed " << #cond << std::endl; failures++; } } while (0)
+
+
+/*************************************************************************/
+/*! This function writes the process file of a test.
+		\param rows is the lines of the file after the header, tab separated
+*/
+/*************************************************************************/
+void write_processes(const std::string& rows)
+{
+	std::ofstream fs(TEST_FILE);
+	fs << "Pid\tBst\tArr\tPri\tDline\tIO" << std::endl << rows;
+}
+
+
+/*************************************************************************/
+/*! This function runs the process file of a test to the end.
+		\param config is the options of the run
+		\param stats is given the statistics of the run
+		\retrun false if the processes could not be loaded
+*/
+/*************************************************************************/
+bool run(const sim_config_t& config, stats_t& stats)
+{
+	Simulator sim;
+	sim.configure(config);
+	if (!sim.load(TEST_FILE))
+	{
+		std::cerr << sim.error() << std::endl;
+		return false;
+	}
+	sim.run();
+	stats = sim.stats();
+	return true;
+}
+
+
+/* a process alone never waits, whatever the frequency of the cpu: below
+ * the top one it takes more ticks of the clock, all of them on the cpu
+ */
+void test_powersave_wait()
+{
+	const char *test = "powersave_wait";
+	sim_config_t config;
+	stats_t stats;
+
+	write_processes("1\t10\t0\t10\t99\t0\n");
+	config.scheduler = FIFO;
+	config.cpu_levels.push_back(cpu_level_t{1000, 250, 40});
+	config.cpu_levels.push_back(cpu_level_t{3000, 2400, 100});
+
+	for (governor_t g : {GOV_PERFORMANCE, GOV_POWERSAVE})
+	{
+		config.governor = g;
+		CHECK(test, run(config, stats));
+		CHECK(test, stats.np == 1);
+		CHECK(test, stats.awt == 0.0);
+		CHECK(test, stats.all.wt.max() == 0);
+		CHECK(test, stats.att == (g == GOV_POWERSAVE? 30.0: 10.0));
+	}
+	remove(TEST_FILE);
+}
+
+
+/* the handlers get every event, not only those of the Gantt chart, and
+ * can only be subscribed before the run starts
+ */
+void test_handler_events()
+{
+	const char *test = "handler_events";
+	sim_config_t config;
+	Simulator sim;
+	std::vector<sim_event_kind_t> kinds;
+
+	write_processes("1\t4\t0\t10\t99\t3\n");
+	config.scheduler = FIFO;
+	config.user_tq = 3; // io a tick before the quantum is over
+	sim.configure(config);
+	CHECK(test, sim.load(TEST_FILE));
+	CHECK(test, sim.subscribe([&kinds](const sim_event_t& e) { if (e.pid == 1) kinds.push_back(e.kind); }));
+	CHECK(test, sim.step());
+	CHECK(test, !sim.subscribe([](const sim_event_t&) {}));
+	sim.run();
+
+	std::vector<sim_event_kind_t> expected = { SIM_ARRIVAL, SIM_DISPATCH, SIM_IO_START, SIM_IO_END, 
+																						 SIM_DISPATCH, SIM_COMPLETION };
+	CHECK(test, kinds == expected);
+	remove(TEST_FILE);
+}
+
+
+/*************************************************************************/
+/*! This function reads the Gantt chart of a test, and removes it.
+		\param name is the name of the chart file
+		\retrun the chart, empty if there was none
+*/
+/*************************************************************************/
+std::string take_chart(const std::string& name)
+{
+	std::ifstream fs(name.c_str());
+	std::stringstream ss;
+	ss << fs.rdbuf();
+	fs.close();
+	remove(name.c_str());
+	return ss.str();
+}
+
+
+/*************************************************************************/
+/*! This function runs the process file of a test to the end, keeping
+		its events and its Gantt chart.
+		\param config is the options of the run
+		\param events is given every event of the run, in order
+		\param chart is given the Gantt chart of the run
+		\param stats is given the statistics of the run
+*/
+/*************************************************************************/
+void run_charted(sim_config_t config, std::vector<sim_event_t>& events, std::string& chart, stats_t& stats)
+{
+	Simulator sim;
+	config.output_name = std::string(TEST_CHART) + (config.packed? PACKED_EXT: "");
+	sim.configure(config);
+	if (!sim.load(TEST_FILE))
+		std::cerr << sim.error() << std::endl;
+	sim.subscribe([&events](const sim_event_t& e) { events.push_back(e); });
+	sim.run();
+	stats = sim.stats();
+	chart = take_chart(config.output_name);
+}
+
+
+/* more than BULK_ARRIVALS processes arriving at a tick are pushed in one
+ * batch, and run as if they had been pushed one at a time
+ */
+void test_bulk_arrivals()
+{
+	const char *test = "bulk_arrivals";
+	std::ostringstream rows;
+
+	srand(1);
+	for (int i=0; i!=BULK_ARRIVALS+500; i++)
+		rows << i+1 << "\t" << rand()%5 + 1 << "\t" << (i < BULK_ARRIVALS+100? 0: 7) << "\t" 
+				 << rand()%100 << "\t" << rand()%99 + 1 << "\t0\n";
+	write_processes(rows.str());
+
+	for (scheduler_t s : {FIFO, SJF, PRIORITY})
+	{
+		sim_config_t config;
+		std::vector<sim_event_t> bulk_events, one_events;
+		std::string bulk_chart, one_chart;
+		stats_t bulk_stats, one_stats;
+
+		config.scheduler = s;
+		config.age_time = 7;
+		run_charted(config, bulk_events, bulk_chart, bulk_stats);
+		config.bulk_arrivals = (size_t) -1;
+		run_charted(config, one_events, one_chart, one_stats);
+
+		CHECK(test, bulk_stats.np == (size_t) BULK_ARRIVALS+500);
+		bool same_events = bulk_events.size() == one_events.size();
+		for (size_t i=0; same_events && i!=bulk_events.size(); i++)
+			same_events = bulk_events[i].Clock == one_events[i].Clock && bulk_events[i].pid == one_events[i].pid && 
+				bulk_events[i].kind == one_events[i].kind;
+		CHECK(test, same_events);
+		CHECK(test, !bulk_chart.empty());
+		CHECK(test, bulk_chart == one_chart);
+		CHECK(test, bulk_stats.awt == one_stats.awt);
+		CHECK(test, bulk_stats.att == one_stats.att);
+	}
+	remove(TEST_FILE);
+}
+
+
+/* the choices of an option are given in any case, as they always were */
+void test_choice_case()
+{
+	const char *test = "choice_case";
+	const option_spec_t table[] =
+	{
+		{"--scheduler", OPT_CHOICE, "fifo,sjf,priority,edf", 0, 0, DEFAULT_SCHEDULER, false, "", NULL}
+	};
+	option_registry options(table, 1);
+	char prog[] = "main", arg[] = "--scheduler=FIFO";
+	char *argv[] = { prog, arg };
+	int argc = 2;
+	CLParser parser(argc, argv);
+
+	CHECK(test, options.check(parser) == "");
+	CHECK(test, options.choice(parser, "--scheduler") == "fifo");
+	CHECK(test, options.check("--scheduler", "Edf") == "");
+	CHECK(test, options.check("--scheduler", "rr") != "");
+}
+
+
+/* --lazy_aging ages the priority scheduler on demand, and schedules as
+ * it does when every process is aged every age_timer ticks
+ */
+void test_lazy_aging()
+{
+	const char *test = "lazy_aging";
+	size_t aged = 0;
+
+	for (unsigned seed=1; seed!=4; seed++)
+	{
+		std::ostringstream rows;
+		srand(seed);
+		for (int i=0; i!=150; i++)
+			rows << i+1 << "\t" << rand()%30 + 1 << "\t" << rand()%300 << "\t" << rand()%100 << "\t" 
+					 << rand()%99 + 1 << "\t" << (rand()%4 == 0? rand()%20: 0) << "\n";
+		write_processes(rows.str());
+
+		for (int age_time : {1, 3, 7, 50, 100})
+			for (int age_val : {0, 1, 10, 60})
+			{
+				sim_config_t config;
+				std::vector<sim_event_t> eager_events, lazy_events;
+				std::string eager_chart, lazy_chart;
+				stats_t eager_stats, lazy_stats;
+
+				config.scheduler = PRIORITY;
+				config.age_time = age_time;
+				config.age_val = age_val;
+				run_charted(config, eager_events, eager_chart, eager_stats);
+				config.lazy_aging = true;
+				run_charted(config, lazy_events, lazy_chart, lazy_stats);
+
+				bool same_events = eager_events.size() == lazy_events.size();
+				for (size_t i=0; same_events && i!=eager_events.size(); i++)
+				{
+					same_events = eager_events[i].Clock == lazy_events[i].Clock && eager_events[i].pid == lazy_events[i].pid && 
+						eager_events[i].kind == lazy_events[i].kind;
+					aged += eager_events[i].kind == SIM_AGING;
+				}
+
+				CHECK(test, same_events);
+				CHECK(test, !eager_chart.empty());
+				CHECK(test, eager_chart == lazy_chart);
+				CHECK(test, eager_stats.awt == lazy_stats.awt);
+				CHECK(test, eager_stats.att == lazy_stats.att);
+			}
+	}
+	CHECK(test, aged != 0);
+	remove(TEST_FILE);
+}
+
+
+/* a run resumed from its last checkpoint ends as the run would have had
+ * it not been stopped: same Gantt chart, same statistics
+ */
+void test_checkpoint_resume()
+{
+	const char *test = "checkpoint_resume";
+	std::ostringstream rows;
+
+	srand(4);
+	for (int i=0; i!=200; i++)
+		rows << i+1 << "\t" << rand()%30 + 1 << "\t" << rand()%400 << "\t" << rand()%100 << "\t" 
+				 << rand()%99 + 1 << "\t" << (rand()%4 == 0? rand()%20: 0) << "\n";
+	write_processes(rows.str());
+
+	for (scheduler_t s : {FIFO, SJF, PRIORITY, EDF})
+	{
+		sim_config_t config;
+		std::vector<sim_event_t> events;
+		std::string whole_chart, resumed_chart;
+		stats_t whole_stats, resumed_stats;
+
+		config.scheduler = s;
+		config.switch_cost = 1;
+		config.io_devices = 2;
+		run_charted(config, events, whole_chart, whole_stats);
+
+		/* the run which is stopped, leaving its chart and last checkpoint */
+		config.output_name = TEST_CHART;
+		config.checkpoint_every = 97;
+		config.checkpoint_name = TEST_CHECKPOINT;
+		Simulator sim;
+		sim.configure(config);
+		CHECK(test, sim.load(TEST_FILE));
+		sim.run();
+
+		config.resume = true;
+		run_charted(config, events, resumed_chart, resumed_stats);
+
+		CHECK(test, !whole_chart.empty());
+		CHECK(test, resumed_chart == whole_chart);
+		CHECK(test, resumed_stats.np == whole_stats.np);
+		CHECK(test, resumed_stats.awt == whole_stats.awt);
+		CHECK(test, resumed_stats.att == whole_stats.att);
+		CHECK(test, resumed_stats.all.wt.max() == whole_stats.all.wt.max());
+		remove(TEST_CHECKPOINT);
+	}
+	remove(TEST_FILE);
+}
+
+
+/* a branch goes on from the state of the run at the fork clock as a run
+ * of its own would: forked at 0 it is the whole run of its scheduler,
+ * and later the branch of the scheduler of the run is the run unforked
+ */
+void test_fork_branches()
+{
+	const char *test = "fork_branches";
+	const scheduler_t schedulers[] = {FIFO, SJF, PRIORITY, EDF};
+	std::ostringstream rows;
+
+	srand(5);
+	for (int i=0; i!=200; i++)
+		rows << i+1 << "\t" << rand()%30 + 1 << "\t" << rand()%400 << "\t" << rand()%100 << "\t" 
+				 << rand()%99 + 1 << "\t" << (rand()%4 == 0? rand()%20: 0) << "\n";
+	write_processes(rows.str());
+
+	for (size_t fork_at : {(size_t) 0, (size_t) 300})
+		for (scheduler_t s : schedulers)
+		{
+			sim_config_t config;
+			config.scheduler = s;
+			config.io_devices = 2;
+			for (scheduler_t b : schedulers)
+				config.branches.push_back(branch_t{b, config.user_tq, config.kernel_tq});
+			config.fork_at = fork_at;
+			config.output_name = TEST_CHART;
+
+			Simulator sim;
+			sim.configure(config);
+			CHECK(test, sim.load(TEST_FILE));
+			CHECK(test, !sim.run());
+			CHECK(test, sim.branch_stats().size() == 4);
+			take_chart(TEST_CHART);
+
+			for (size_t i=0; i!=4 && i!=sim.branch_stats().size(); i++)
+			{
+				std::string branch_chart = take_chart(TEST_CHART "-branch" + std::to_string(i+1));
+				if (fork_at != 0 && schedulers[i] != s)
+					continue;
+
+				sim_config_t whole = config;
+				std::vector<sim_event_t> events;
+				std::string chart;
+				stats_t stats;
+				const stats_t& branch = sim.branch_stats()[i];
+
+				whole.scheduler = schedulers[i];
+				whole.branches.clear();
+				whole.fork_at = NO_FORK;
+				run_charted(whole, events, chart, stats);
+
+				CHECK(test, branch.np == stats.np);
+				CHECK(test, branch.awt == stats.awt);
+				CHECK(test, branch.att == stats.att);
+				CHECK(test, branch.all.wt.max() == stats.all.wt.max());
+				if (fork_at == 0)
+					CHECK(test, branch_chart == chart);
+			}
+		}
+	remove(TEST_FILE);
+}
+
+
+/* a packed chart is read back by gantt_reader as the text chart of the
+ * same run, resumed from a checkpoint or not
+ */
+void test_packed_chart()
+{
+	const char *test = "packed_chart";
+	std::ostringstream rows;
+
+	srand(6);
+	for (int i=0; i!=300; i++)
+		rows << i+1 << "\t" << rand()%30 + 1 << "\t" << rand()%3000 << "\t" << rand()%100 << "\t" 
+				 << rand()%99 + 1 << "\t" << (rand()%4 == 0? rand()%20: 0) << "\n";
+	write_processes(rows.str());
+
+	for (scheduler_t s : {FIFO, PRIORITY, EDF})
+	{
+		sim_config_t config;
+		std::vector<sim_event_t> events;
+		std::string text_chart, packed_chart, resumed_chart;
+		stats_t stats;
+
+		config.scheduler = s;
+		config.io_devices = 2;
+		run_charted(config, events, text_chart, stats);
+		config.packed = true;
+		run_charted(config, events, packed_chart, stats);
+
+		std::istringstream is(packed_chart);
+		gantt_reader reader(is);
+		std::ostringstream os;
+		gantt_event_t e;
+		os << GANTT_HEADER;
+		while (reader.next(e))
+			os << e.Clock << "\t" << e.pid << "\t" << gantt_action_text[e.action] << "\n";
+		CHECK(test, reader.good());
+		CHECK(test, text_chart.size() > sizeof(GANTT_HEADER));
+		CHECK(test, packed_chart.size() < text_chart.size());
+		CHECK(test, os.str() == text_chart);
+
+		/* the encoder state is in the checkpoint, so not a byte changes */
+		config.output_name = TEST_CHART PACKED_EXT;
+		config.checkpoint_every = 211;
+		config.checkpoint_name = TEST_CHECKPOINT;
+		Simulator sim;
+		sim.configure(config);
+		CHECK(test, sim.load(TEST_FILE));
+		sim.run();
+		config.resume = true;
+		run_charted(config, events, resumed_chart, stats);
+		CHECK(test, resumed_chart == packed_chart);
+		remove(TEST_CHECKPOINT);
+	}
+	remove(TEST_FILE);
+}
+
+
+/* busy groups get the cpu in proportion to their shares: a with three
+ * times the shares of b is done with the same work in a third of the
+ * ticks b then still has to run
+ */
+void test_group_shares()
+{
+	const char *test = "group_shares";
+	std::ostringstream rows;
+	sim_config_t config;
+	std::vector<sim_event_t> events;
+	std::string chart;
+	stats_t stats;
+	size_t a_end = 0, b_end = 0;
+
+	for (int i=0; i!=8; i++) // Pid Bst Arr Pri Dline IO Dev Pos Phases Group
+		rows << i+1 << "\t1500\t0\t10\t99\t0\t0\t0\t-\t" << (i < 4? "a": "b") << "\n";
+	write_processes(rows.str());
+
+	config.scheduler = FIFO;
+	config.group_shares.push_back(std::make_pair(std::string("a"), 3 * DEFAULT_SHARES));
+	run_charted(config, events, chart, stats);
+	for (const sim_event_t& e : events)
+		if (e.kind == SIM_COMPLETION)
+			(e.pid <= 4? a_end: b_end) = e.Clock;
+
+	CHECK(test, stats.np == 8);
+	CHECK(test, b_end == 12000);
+	CHECK(test, a_end >= 7900 && a_end <= 8100); // 6000 ticks at 3/4 of the cpu
+	CHECK(test, stats.groups.size() == 3);
+	for (const group_stats_t& g : stats.groups)
+	{
+		CHECK(test, g.cpu == (g.name == ""? 12000: 6000));
+		CHECK(test, g.ended == (g.name == ""? 8: 4));
+		CHECK(test, g.shares == (g.name == "a"? 3 * DEFAULT_SHARES: DEFAULT_SHARES));
+	}
+	remove(TEST_FILE);
+}
+
+
+/* a limit of 25 ticks every 100 runs process 1, of 1000 ticks, in 40
+ * periods, each of which uses the quota up. It is throttled for the rest
+ * of each period but the last, except while the kernel process 2, under
+ * neither limit, runs: 75+50+25 ticks, then 36 periods of 75, ending at
+ * 3925. The accounting goes through a checkpoint unchanged.
+ */
+void test_cpu_quota()
+{
+	const char *test = "cpu_quota";
+
+	write_processes("1\t1000\t0\t10\t99\t0\t0\t0\t-\ta\n"
+									"2\t200\t0\t60\t99\t0\t0\t0\t-\tb\n");
+
+	for (const char *name : {"a", USER_CLASS})
+	{
+		sim_config_t config;
+		std::vector<sim_event_t> events;
+		std::string chart, resumed_chart;
+		stats_t stats, resumed_stats;
+
+		config.scheduler = FIFO;
+		config.cpu_quotas.push_back(quota_spec_t{name, 25, 100});
+		run_charted(config, events, chart, stats);
+
+		CHECK(test, stats.np == 2);
+		CHECK(test, stats.bandwidth.size() == 1);
+		for (const bandwidth_stats_t& b : stats.bandwidth)
+		{
+			CHECK(test, b.name == name);
+			CHECK(test, b.periods == 40);
+			CHECK(test, b.throttles == 40);
+			CHECK(test, b.throttled == 75 + 50 + 25 + 36 * 75);
+		}
+		CHECK(test, stats.att == (3925 + 250) / 2.0);
+
+		config.output_name = TEST_CHART;
+		config.checkpoint_every = 97;
+		config.checkpoint_name = TEST_CHECKPOINT;
+		Simulator sim;
+		sim.configure(config);
+		CHECK(test, sim.load(TEST_FILE));
+		sim.run();
+		config.resume = true;
+		run_charted(config, events, resumed_chart, resumed_stats);
+		remove(TEST_CHECKPOINT);
+
+		CHECK(test, resumed_chart == chart);
+		CHECK(test, resumed_stats.att == stats.att);
+		CHECK(test, resumed_stats.bandwidth.size() == stats.bandwidth.size());
+		for (size_t i=0; i!=stats.bandwidth.size() && i!=resumed_stats.bandwidth.size(); i++)
+		{
+			CHECK(test, resumed_stats.bandwidth[i].periods == stats.bandwidth[i].periods);
+			CHECK(test, resumed_stats.bandwidth[i].throttles == stats.bandwidth[i].throttles);
+			CHECK(test, resumed_stats.bandwidth[i].throttled == stats.bandwidth[i].throttled);
+		}
+	}
+	remove(TEST_FILE);
+}
+
+
+int main()
+{
+	test_choice_case();
+	test_powersave_wait();
+	test_handler_events();
+	test_bulk_arrivals();
+	test_lazy_aging();
+	test_checkpoint_resume();
+	test_fork_branches();
+	test_packed_chart();
+	test_group_shares();
+	test_cpu_quota();
+
+	if (failures != 0)
+	{
+		std::cerr << failures << " checks failed" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	std::cerr << "all tests passed" << std::endl;
+	return 0;
+}
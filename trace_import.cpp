@@ -0,0 +1,80 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "sched_trace.h"
+
+#define TRACE_BUFFER (1 << 20) // bytes read from the trace at a time
+
+/*************************************************************************/
+/*! Turns a Linux scheduler trace (sched_switch and sched_wakeup events,
+		from ftrace or perf script) into a process file the scheduler can
+		run, with one process per task. The trace is read as a stream, one
+		line at a time, so it can be piped in ('-') whatever its size; only
+		the phases of the tasks are kept.
+		usage: ./trace_import <trace-file|-> <process-file> [<usecs-per-tick>]
+*/
+/*************************************************************************/
+int main(int argc, char *argv[])
+{
+	if (argc != 3 && argc != 4)
+	{
+		std::cerr << "usage: " << argv[0] << " <trace-file|-> <process-file> [<usecs-per-tick>]" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	long usecs = argc == 4? strtol(argv[3], NULL, 10): 1000;
+	if (usecs <= 0)
+	{
+		std::cerr << "The ticks must be at least a microsecond" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::vector<char> buffer(TRACE_BUFFER);
+	std::ifstream file;
+	std::istream *in = &std::cin;
+	std::ios::sync_with_stdio(false);
+	if (std::string(argv[1]) != "-")
+	{
+		file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+		file.open(argv[1]);
+		if (!file.is_open())
+		{
+			std::cerr << "Could not read file \'" << argv[1] << "\'" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+		in = &file;
+	}
+
+	trace_importer importer((uint64_t) usecs * 1000);
+	trace_event_t e;
+	std::string line;
+	while (std::getline(*in, line))
+	{
+		if (parse_trace_line(line.c_str(), e))
+			importer.add(e);
+		else
+			importer.skipped++;
+	}
+	importer.finish();
+
+	FILE *fp = fopen(argv[2], "w");
+	if (!fp)
+	{
+		std::cerr << "Could not write file \'" << argv[2] << "\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	size_t n = importer.write(fp);
+	if (fclose(fp) != 0)
+	{
+		std::cerr << "Could not write file \'" << argv[2] << "\'" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::cerr << importer.events << " events, " << importer.skipped << " other lines, ";
+	std::cerr << n << " processes" << std::endl;
+	return 0;
+}